@@ -0,0 +1,103 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <opencv2/opencv.hpp>
+#include <random>
+#include <vector>
+
+#include "tasks/yolos/yolo_decoder.hpp"
+
+// YOLOV5::parse原先的逐行解码，作为对照
+static int legacy_decode(const cv::Mat & output, double scale, float score_threshold)
+{
+  auto sigmoid = [](double x) {
+    return x > 0 ? 1.0 / (1.0 + std::exp(-x)) : std::exp(x) / (1.0 + std::exp(x));
+  };
+
+  std::vector<int> color_ids, num_ids;
+  std::vector<float> confidences;
+  std::vector<cv::Rect> boxes;
+  std::vector<std::vector<cv::Point2f>> armors_key_points;
+  for (int r = 0; r < output.rows; r++) {
+    double score = sigmoid(output.at<float>(r, 8));
+    if (score < score_threshold) continue;
+
+    cv::Mat color_scores = output.row(r).colRange(9, 13);
+    cv::Mat classes_scores = output.row(r).colRange(13, 22);
+    cv::Point class_id, color_id;
+    double score_color, score_num;
+    cv::minMaxLoc(classes_scores, NULL, &score_num, NULL, &class_id);
+    cv::minMaxLoc(color_scores, NULL, &score_color, NULL, &color_id);
+
+    std::vector<cv::Point2f> armor_key_points;
+    armor_key_points.push_back(
+      cv::Point2f(output.at<float>(r, 0) / scale, output.at<float>(r, 1) / scale));
+    armor_key_points.push_back(
+      cv::Point2f(output.at<float>(r, 6) / scale, output.at<float>(r, 7) / scale));
+    armor_key_points.push_back(
+      cv::Point2f(output.at<float>(r, 4) / scale, output.at<float>(r, 5) / scale));
+    armor_key_points.push_back(
+      cv::Point2f(output.at<float>(r, 2) / scale, output.at<float>(r, 3) / scale));
+
+    float min_x = armor_key_points[0].x, max_x = armor_key_points[0].x;
+    float min_y = armor_key_points[0].y, max_y = armor_key_points[0].y;
+    for (int i = 1; i < armor_key_points.size(); i++) {
+      min_x = std::min(min_x, armor_key_points[i].x);
+      max_x = std::max(max_x, armor_key_points[i].x);
+      min_y = std::min(min_y, armor_key_points[i].y);
+      max_y = std::max(max_y, armor_key_points[i].y);
+    }
+
+    cv::Rect rect(min_x, min_y, max_x - min_x, max_y - min_y);
+    color_ids.emplace_back(color_id.x);
+    num_ids.emplace_back(class_id.x);
+    boxes.emplace_back(rect);
+    confidences.emplace_back(score);
+    armors_key_points.emplace_back(armor_key_points);
+  }
+  return static_cast<int>(boxes.size());
+}
+
+int main(int argc, char ** argv)
+{
+  const int rows = 25200, cols = 22;
+  const float score_threshold = 0.7f;
+  const double scale = 0.5;
+  const int iterations = argc > 1 ? std::stoi(argv[1]) : 500;
+
+  // 模拟真实输出：绝大多数行的objectness远低于阈值，少量行命中
+  std::mt19937 rng(42);
+  std::normal_distribution<float> logit(-8.0f, 2.5f);
+  std::uniform_real_distribution<float> coord(0.0f, 640.0f), onehot(-4.0f, 4.0f);
+  cv::Mat output(rows, cols, CV_32F);
+  for (int r = 0; r < rows; r++) {
+    auto * row = output.ptr<float>(r);
+    for (int c = 0; c < 8; c++) row[c] = coord(rng);
+    row[8] = logit(rng);
+    for (int c = 9; c < cols; c++) row[c] = onehot(rng);
+  }
+
+  auto_aim::YOLOV5Decoder decoder(score_threshold);
+  auto legacy_count = legacy_decode(output, scale, score_threshold);
+  auto decoder_count = static_cast<int>(decoder.decode(output, scale).size());
+
+  auto time_us = [&](auto && fn) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) fn();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::micro>(end - start).count() / iterations;
+  };
+
+  volatile int sink = 0;
+  auto legacy_us = time_us([&] { sink = legacy_decode(output, scale, score_threshold); });
+  auto decoder_us = time_us([&] { sink = decoder.decode(output, scale).size(); });
+
+  std::cout << "rows: " << rows << ", candidates: legacy " << legacy_count << " / decoder "
+            << decoder_count << std::endl;
+  std::cout << "legacy parse:  " << legacy_us << " us/frame" << std::endl;
+  std::cout << "YOLOV5Decoder: " << decoder_us << " us/frame (x" << legacy_us / decoder_us << ")"
+            << std::endl;
+
+  return legacy_count == decoder_count ? 0 : 1;
+}
@@ -0,0 +1,137 @@
+#include <yaml-cpp/yaml.h>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+
+#include "tasks/yolo.hpp"
+
+// 在录像上遍历OpenVINO编译参数组合，比较吞吐与单帧时延
+// 用法: hint_benchmark [yolo.yaml] [benchmark.yaml]
+
+using Clock = std::chrono::steady_clock;
+
+// 网格中需要遍历的yolo.yaml配置项
+static const std::vector<std::string> GRID_KEYS = {
+  "performance_mode",    "num_streams",          "inference_threads",
+  "inference_precision", "scheduling_core_type", "infer_requests"};
+
+struct Stats
+{
+  double fps;
+  double p50_ms;
+  double p99_ms;
+};
+
+static double percentile(std::vector<double> values, double p)
+{
+  if (values.empty()) return 0.0;
+  auto n = static_cast<std::size_t>(p * (values.size() - 1) + 0.5);
+  std::nth_element(values.begin(), values.begin() + n, values.end());
+  return values[n];
+}
+
+static Stats run(const std::string & config_path, const std::vector<cv::Mat> & frames, int warmup)
+{
+  auto_aim::YOLO yolo(config_path, false);
+
+  std::map<int, Clock::time_point> submit_times;
+  std::vector<double> latencies;
+  latencies.reserve(frames.size());
+  Clock::time_point start;
+
+  auto collect_one = [&] {
+    auto result = yolo.collect();
+    if (!result) return;
+    auto it = submit_times.find(result->frame_count);
+    if (result->frame_count >= warmup)
+      latencies.push_back(
+        std::chrono::duration<double, std::milli>(Clock::now() - it->second).count());
+    submit_times.erase(it);
+  };
+
+  for (int i = 0; i < static_cast<int>(frames.size()); i++) {
+    if (i == warmup) start = Clock::now();
+    submit_times[i] = Clock::now();
+    while (!yolo.detect_async(frames[i], i)) collect_one();
+  }
+  while (!submit_times.empty()) collect_one();
+
+  auto seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  return {latencies.size() / seconds, percentile(latencies, 0.5), percentile(latencies, 0.99)};
+}
+
+int main(int argc, char ** argv)
+{
+  std::string yolo_path = argc > 1 ? argv[1] : "./configs/yolo.yaml";
+  std::string bench_path = argc > 2 ? argv[2] : "./configs/benchmark.yaml";
+
+  auto base = YAML::LoadFile(yolo_path);
+  auto bench = YAML::LoadFile(bench_path);
+  auto video_path = bench["video_path"].as<std::string>();
+  auto max_frames = bench["max_frames"].as<int>();
+  auto warmup = bench["warmup_frames"].as<int>();
+
+  // 预先解码到内存，避免视频解码影响测量
+  cv::VideoCapture cap(video_path);
+  if (!cap.isOpened()) {
+    std::cerr << "Failed to open video: " << video_path << std::endl;
+    return -1;
+  }
+  std::vector<cv::Mat> frames;
+  cv::Mat img;
+  while (static_cast<int>(frames.size()) < max_frames && cap.read(img)) frames.push_back(img.clone());
+  if (static_cast<int>(frames.size()) <= warmup) {
+    std::cerr << "Not enough frames in " << video_path << std::endl;
+    return -1;
+  }
+  std::cout << "Loaded " << frames.size() << " frames from " << video_path << std::endl;
+
+  auto tmp_path = (std::filesystem::temp_directory_path() / "hint_benchmark.yaml").string();
+
+  // 按GRID_KEYS遍历所有组合
+  std::vector<std::size_t> index(GRID_KEYS.size(), 0);
+  std::cout << std::left << std::setw(72) << "config" << std::setw(10) << "fps"
+            << std::setw(10) << "p50(ms)" << "p99(ms)" << std::endl;
+  while (true) {
+    YAML::Node config = YAML::Clone(base);
+    std::string name;
+    for (std::size_t k = 0; k < GRID_KEYS.size(); k++) {
+      auto value = bench[GRID_KEYS[k]][index[k]];
+      config[GRID_KEYS[k]] = value;
+      name += GRID_KEYS[k] + "=" + value.as<std::string>() + " ";
+    }
+
+    {
+      YAML::Emitter out;
+      out << config;
+      std::ofstream(tmp_path) << out.c_str();
+    }
+
+    try {
+      auto stats = run(tmp_path, frames, warmup);
+      std::cout << std::left << std::setw(72) << name << std::fixed << std::setprecision(1)
+                << std::setw(10) << stats.fps << std::setw(10) << stats.p50_ms << stats.p99_ms
+                << std::endl;
+    } catch (const std::exception & e) {
+      std::cout << std::left << std::setw(72) << name << "failed: " << e.what() << std::endl;
+    }
+
+    std::size_t k = 0;
+    for (; k < GRID_KEYS.size(); k++) {
+      if (++index[k] < bench[GRID_KEYS[k]].size()) break;
+      index[k] = 0;
+    }
+    if (k == GRID_KEYS.size()) break;
+  }
+
+  std::filesystem::remove(tmp_path);
+  return 0;
+}
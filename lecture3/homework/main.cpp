@@ -2,6 +2,7 @@
 #include "tasks/yolo.hpp"
 #include "opencv2/opencv.hpp"
 #include "tools/img_tools.hpp"
+#include "tools/overlay.hpp"
 #include <iostream>
 #include <filesystem>
 
@@ -22,6 +23,10 @@ int main()
         auto_aim::YOLO yolo_detector(config_path, true);  // 第二个参数是debug模式
         
         std::cout << "YOLO detector initialized successfully!" << std::endl;
+
+        // 调试画面的异步渲染，本程序显示窗口因此订阅
+        tools::Overlay overlay(0.5);
+        overlay.subscribe();
         
         int frame_count = 0;
         
@@ -41,29 +46,35 @@ int main()
             // 调用yolo识别装甲板
             std::list<auto_aim::Armor> armors = yolo_detector.detect(img, frame_count);
             
-            // 在图像上绘制检测结果
-            for (const auto& armor : armors) {
-                // 使用红色绘制装甲板的四个关键点（闭合矩形）
-                tools::draw_points(img, armor.points, cv::Scalar(0, 0, 255), 2);
-                
-                // 在装甲板中心绘制文本信息
-                std::string armor_info = auto_aim::COLORS[armor.color] + " " + 
-                                       auto_aim::ARMOR_NAMES[armor.name];
-                tools::draw_text(img, armor_info, 
-                               cv::Point(armor.points[0].x, armor.points[0].y - 10),
-                               cv::Scalar(0, 255, 255), 0.5, 2);
-            }
-            
-            // 显示检测到的装甲板数量
-            if (!armors.empty()) {
-                std::string count_info = "Detected: " + std::to_string(armors.size()) + " armors";
-                tools::draw_text(img, count_info, cv::Point(10, 30),
-                               cv::Scalar(0, 255, 0), 3, 2);
-            }
-            
-            // 显示图像
-            cv::resize(img, img, cv::Size(1280, 960));
-            cv::imshow("Armor Detection", img);
+            // 绘制交给渲染线程，在缩小后的副本上进行，不影响检测
+            overlay.submit(img, [armors, frame_count](cv::Mat & canvas, double scale) {
+                tools::draw_text(canvas, "[" + std::to_string(frame_count) + "]",
+                               cv::Point(10, 30), cv::Scalar(255, 255, 255), 0.7, 2);
+                for (const auto& armor : armors) {
+                    // 使用红色绘制装甲板的四个关键点（闭合矩形）
+                    std::vector<cv::Point2f> points;
+                    for (const auto& point : armor.points) points.push_back(point * scale);
+                    tools::draw_points(canvas, points, cv::Scalar(0, 0, 255), 2);
+
+                    // 在装甲板左上角绘制文本信息
+                    std::string armor_info = auto_aim::COLORS[armor.color] + " " + 
+                                           auto_aim::ARMOR_NAMES[armor.name];
+                    tools::draw_text(canvas, armor_info, 
+                                   cv::Point(points[0].x, points[0].y - 10),
+                                   cv::Scalar(0, 255, 255), 0.5, 2);
+                }
+
+                // 显示检测到的装甲板数量
+                if (!armors.empty()) {
+                    std::string count_info = "Detected: " + std::to_string(armors.size()) + " armors";
+                    tools::draw_text(canvas, count_info, cv::Point(10, 60),
+                                   cv::Scalar(0, 255, 0), 0.7, 2);
+                }
+            });
+
+            // 显示最近一次渲染完成的画面
+            cv::Mat canvas;
+            if (overlay.take(canvas)) cv::imshow("Armor Detection", canvas);
             
             frame_count++;
             
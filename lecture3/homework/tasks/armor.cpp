@@ -172,11 +172,7 @@ Armor::Armor(
   rectangular_error = std::max(left_rectangular_error, right_rectangular_error);
 
   ratio = max_length / max_width;
-  color = color_id == 0 ? Color::blue : color_id == 1 ? Color::red : Color::extinguish;
-  name = num_id == 0  ? ArmorName::sentry
-         : num_id > 5 ? ArmorName(num_id)
-                      : ArmorName(num_id - 1);  //TODO 考虑Bb
-  type = num_id == 1 ? ArmorType::big : ArmorType::small;
+  std::tie(color, name, type) = yolov5_properties(color_id, num_id);
 }
 
 // YOLOV5+ROI构造函数
@@ -213,9 +209,42 @@ Armor::Armor(
   rectangular_error = std::max(left_rectangular_error, right_rectangular_error);
 
   ratio = max_length / max_width;
-  color = color_id == 0 ? Color::blue : color_id == 1 ? Color::red : Color::extinguish;
-  name = num_id == 0 ? ArmorName::sentry : num_id > 5 ? ArmorName(num_id) : ArmorName(num_id - 1);
-  type = num_id == 1 ? ArmorType::big : ArmorType::small;
+  std::tie(color, name, type) = yolov5_properties(color_id, num_id);
+}
+
+// 精简识别结果构造函数
+ArmorDetection::ArmorDetection(
+  int color_id, int num_id, float confidence, const cv::Rect & box,
+  const std::array<cv::Point2f, 4> & keypoints, cv::Point2f offset)
+: confidence(confidence), box(box)
+{
+  for (std::size_t i = 0; i < points.size(); i++) points[i] = keypoints[i] + offset;
+  center = (points[0] + points[1] + points[2] + points[3]) / 4;
+  std::tie(color, name, type) = yolov5_properties(color_id, num_id);
+}
+
+ArmorDetection::ArmorDetection(const Armor & armor)
+: color(armor.color),
+  name(armor.name),
+  type(armor.type),
+  confidence(armor.confidence),
+  box(armor.box),
+  center(armor.center),
+  center_norm(armor.center_norm)
+{
+  std::copy_n(armor.points.begin(), points.size(), points.begin());
+}
+
+// 兼容旧接口：由精简识别结果构造完整的Armor
+Armor::Armor(const ArmorDetection & detection)
+: Armor(
+    0, 0, detection.confidence, detection.box,
+    std::vector<cv::Point2f>(detection.points.begin(), detection.points.end()))
+{
+  color = detection.color;
+  name = detection.name;
+  type = detection.type;
+  center_norm = detection.center_norm;
 }
 
 }  // namespace auto_aim
\ No newline at end of file
@@ -3,7 +3,7 @@
  * struct Armor
  * {
  *   Color color;    // 灯条颜色
- *   std::vector<cv::Point2f> points;  // 关键点的图像坐标，顺序为左上、左下、右下、右上
+ *   std::vector<cv::Point2f> points;  // 关键点的图像坐标，顺序为左上、右上、右下、左下
  *   ArmorType type;   // 装甲板尺寸分类（大/小）
  *   ArmorName name;   // 装甲板图案（1/2/3/哨兵）
  * };
@@ -13,8 +13,10 @@
 #define AUTO_AIM__ARMOR_HPP
 
 #include <Eigen/Dense>
+#include <array>
 #include <opencv2/opencv.hpp>
 #include <string>
+#include <tuple>
 #include <vector>
 
 namespace auto_aim
@@ -60,7 +62,7 @@ enum ArmorPriority
 };
 
 // clang-format off
-const std::vector<std::tuple<Color, ArmorName, ArmorType>> armor_properties = {
+constexpr std::array<std::tuple<Color, ArmorName, ArmorType>, 38> armor_properties = {{
   {blue, sentry, small},     {red, sentry, small},     {extinguish, sentry, small},
   {blue, one, small},        {red, one, small},        {extinguish, one, small},
   {blue, two, small},        {red, two, small},        {extinguish, two, small},
@@ -72,9 +74,42 @@ const std::vector<std::tuple<Color, ArmorName, ArmorType>> armor_properties = {
   {blue, base, small},       {red, base, small},       {extinguish, base, small},    {purple, base, small},    
   {blue, three, big},        {red, three, big},        {extinguish, three, big}, 
   {blue, four, big},         {red, four, big},         {extinguish, four, big},  
-  {blue, five, big},         {red, five, big},         {extinguish, five, big}};
+  {blue, five, big},         {red, five, big},         {extinguish, five, big}}};
 // clang-format on
 
+// YOLOV5的颜色和类别编号到装甲板属性的映射，编译期求值
+constexpr std::tuple<Color, ArmorName, ArmorType> yolov5_properties(int color_id, int num_id)
+{
+  auto color = color_id == 0 ? Color::blue : color_id == 1 ? Color::red : Color::extinguish;
+  auto name = num_id == 0  ? ArmorName::sentry
+              : num_id > 5 ? ArmorName(num_id)
+                           : ArmorName(num_id - 1);  //TODO 考虑Bb
+  auto type = num_id == 1 ? ArmorType::big : ArmorType::small;
+  return {color, name, type};
+}
+
+struct Armor;
+
+// 神经网络识别结果的精简表示，只保留后处理热路径用到的字段，可平凡拷贝，连续存储时没有堆分配
+struct ArmorDetection
+{
+  Color color;
+  ArmorName name;
+  ArmorType type;
+  float confidence;
+  cv::Rect box;
+  std::array<cv::Point2f, 4> points;  // 关键点的图像坐标，顺序为左上、右上、右下、左下
+  cv::Point2f center;
+  cv::Point2f center_norm;
+
+  ArmorDetection() = default;
+  // YOLOV5+ROI：按网络输出的颜色和图案编号确定属性，关键点加上裁剪区域偏移
+  ArmorDetection(
+    int color_id, int num_id, float confidence, const cv::Rect & box,
+    const std::array<cv::Point2f, 4> & keypoints, cv::Point2f offset);
+  explicit ArmorDetection(const Armor & armor);
+};
+
 struct Lightbar
 {
   std::size_t id;
@@ -94,7 +129,7 @@ struct Armor
   Lightbar left, right;     
   cv::Point2f center;       
   cv::Point2f center_norm;  
-  std::vector<cv::Point2f> points;  // 关键点的图像坐标，顺序为左上、左下、右下、右上
+  std::vector<cv::Point2f> points;  // 关键点的图像坐标，顺序为左上、右上、右下、左下
 
   double ratio;              
   double side_ratio;         
@@ -129,6 +164,7 @@ struct Armor
   Armor(
     int color_id, int num_id, float confidence, const cv::Rect & box,
     std::vector<cv::Point2f> armor_keypoints, cv::Point2f offset);
+  explicit Armor(const ArmorDetection & detection);
 };
 
 }  // namespace auto_aim
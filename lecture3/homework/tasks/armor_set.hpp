@@ -0,0 +1,60 @@
+#ifndef AUTO_AIM__ARMOR_SET_HPP
+#define AUTO_AIM__ARMOR_SET_HPP
+
+#include <algorithm>
+#include <list>
+#include <vector>
+
+#include "tasks/armor.hpp"
+
+namespace auto_aim
+{
+/**
+ * 一帧的识别结果，作为该帧的arena：ArmorDetection连续存储，clear只重置长度，
+ * 容量在帧间复用，稳态下后处理不产生堆分配。
+ * 旧接口通过to_list转换为std::list<Armor>。
+ */
+class ArmorSet
+{
+public:
+  using iterator = std::vector<ArmorDetection>::iterator;
+  using const_iterator = std::vector<ArmorDetection>::const_iterator;
+
+  explicit ArmorSet(std::size_t capacity = 16) { items_.reserve(capacity); }
+
+  void clear() { items_.clear(); }
+  void push_back(const ArmorDetection & detection) { items_.push_back(detection); }
+
+  template <typename... Args>
+  ArmorDetection & emplace_back(Args &&... args)
+  {
+    return items_.emplace_back(std::forward<Args>(args)...);
+  }
+
+  // 原地删除满足条件的结果，保持原有顺序
+  template <typename Pred>
+  void remove_if(Pred pred)
+  {
+    items_.erase(std::remove_if(items_.begin(), items_.end(), pred), items_.end());
+  }
+
+  std::size_t size() const { return items_.size(); }
+  bool empty() const { return items_.empty(); }
+
+  ArmorDetection & operator[](std::size_t i) { return items_[i]; }
+  const ArmorDetection & operator[](std::size_t i) const { return items_[i]; }
+
+  iterator begin() { return items_.begin(); }
+  iterator end() { return items_.end(); }
+  const_iterator begin() const { return items_.begin(); }
+  const_iterator end() const { return items_.end(); }
+
+  std::list<Armor> to_list() const { return std::list<Armor>(items_.begin(), items_.end()); }
+
+private:
+  std::vector<ArmorDetection> items_;
+};
+
+}  // namespace auto_aim
+
+#endif  // AUTO_AIM__ARMOR_SET_HPP
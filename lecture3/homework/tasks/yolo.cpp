@@ -2,6 +2,9 @@
 
 #include <yaml-cpp/yaml.h>
 
+#include <algorithm>
+
+#include "tools/nms.hpp"
 #include "yolos/yolov5.hpp"
 
 namespace auto_aim
@@ -18,11 +21,108 @@ YOLO::YOLO(const std::string & config_path, bool debug)
   else {
     throw std::runtime_error("Unknown yolo name: " + yolo_name + "!");
   }
+
+  cascade_ = yaml["cascade"].as<bool>();
+  cascade_crop_size_ = yaml["cascade_crop_size"].as<int>();
+  cascade_max_crops_ = yaml["cascade_max_crops"].as<std::size_t>();
 }
 
 std::list<Armor> YOLO::detect(const cv::Mat & img, int frame_count)
 {
+  if (cascade_) return detect_cascade(img, frame_count);
   return yolo_->detect(img, frame_count);
 }
 
+const ArmorSet & YOLO::detect_set(const cv::Mat & img, int frame_count)
+{
+  if (!cascade_) return yolo_->detect_set(img, frame_count);
+
+  cascade_armors_.clear();
+  for (const auto & armor : detect_cascade(img, frame_count))
+    cascade_armors_.emplace_back(armor);
+  return cascade_armors_;
+}
+
+std::list<Armor> YOLO::detect_cascade(const cv::Mat & img, int frame_count)
+{
+  // 低分辨率全图粗检
+  auto coarse = yolo_->detect_coarse(img, frame_count);
+  if (coarse.empty()) return coarse;
+
+  // 在粗检结果周围按原始分辨率裁剪，已被某个裁剪区域完整包含的装甲板不再单独裁剪
+  std::vector<cv::Rect> rois;
+  std::vector<std::list<Armor>> fallbacks;  // 每个裁剪区域内的粗检结果，精检未识别时使用
+  std::list<Armor> armors;
+  for (auto & armor : coarse) {
+    auto covered = std::find_if(rois.begin(), rois.end(), [&](const cv::Rect & roi) {
+      return std::all_of(armor.points.begin(), armor.points.end(), [&](const cv::Point2f & p) {
+        return roi.contains(p);
+      });
+    });
+    if (covered != rois.end()) {
+      fallbacks[covered - rois.begin()].push_back(armor);
+      continue;
+    }
+
+    // 超出批大小的装甲板直接采用粗检结果
+    if (rois.size() == cascade_max_crops_) {
+      armors.push_back(armor);
+      continue;
+    }
+
+    auto width = std::min(cascade_crop_size_, img.cols);
+    auto height = std::min(cascade_crop_size_, img.rows);
+    auto x = std::clamp(static_cast<int>(armor.center.x) - width / 2, 0, img.cols - width);
+    auto y = std::clamp(static_cast<int>(armor.center.y) - height / 2, 0, img.rows - height);
+    rois.emplace_back(x, y, width, height);
+    fallbacks.emplace_back(1, armor);
+  }
+
+  auto refined = yolo_->detect_regions(img, rois, frame_count);
+  for (std::size_t i = 0; i < rois.size(); i++) {
+    auto & result = refined[i].empty() ? fallbacks[i] : refined[i];
+    armors.splice(armors.end(), result);
+  }
+
+  // 相邻裁剪区域重叠处可能重复识别同一块装甲板，保留置信度高的
+  armors.sort([](const Armor & a, const Armor & b) { return a.confidence > b.confidence; });
+  for (auto it = armors.begin(); it != armors.end(); ++it) {
+    auto box = cv::boundingRect(it->points);
+    for (auto other = std::next(it); other != armors.end();) {
+      if (tools::iou(box, cv::boundingRect(other->points)) > 0.3f)
+        other = armors.erase(other);
+      else
+        ++other;
+    }
+  }
+
+  return armors;
+}
+
+bool YOLO::detect_async(const cv::Mat & img, int frame_count)
+{
+  if (!cascade_) return yolo_->detect_async(img, frame_count);
+
+  // 级联检测的精检依赖粗检结果，无法与下一帧的推理重叠，提交时同步完成，保证结果与detect一致；
+  // 相当于只有一个infer request，上一帧的结果未取回时返回false
+  if (!cascade_results_.empty()) return false;
+  cascade_results_.push_back({frame_count, img, detect_cascade(img, frame_count)});
+  return true;
+}
+
+std::optional<YOLOBase::Result> YOLO::collect()
+{
+  if (!cascade_) return yolo_->collect();
+
+  if (cascade_results_.empty()) return std::nullopt;
+  auto result = std::move(cascade_results_.front());
+  cascade_results_.pop_front();
+  return result;
+}
+
+std::vector<std::list<Armor>> YOLO::detect_batch(const std::vector<cv::Mat> & imgs, int frame_count)
+{
+  return yolo_->detect_batch(imgs, frame_count);
+}
+
 }  // namespace auto_aim
\ No newline at end of file
@@ -1,17 +1,53 @@
 #ifndef AUTO_AIM__YOLO_HPP
 #define AUTO_AIM__YOLO_HPP
 
+#include <deque>
+#include <list>
+#include <memory>
 #include <opencv2/opencv.hpp>
+#include <optional>
+#include <vector>
 
 #include "armor.hpp"
+#include "armor_set.hpp"
 
 namespace auto_aim
 {
 class YOLOBase
 {
 public:
+  // 异步接口的返回结果，img为提交时的原图（引用计数，不拷贝）
+  struct Result
+  {
+    int frame_count;
+    cv::Mat img;
+    std::list<Armor> armors;
+  };
+
+  virtual ~YOLOBase() = default;
+
   virtual std::list<Armor> detect(const cv::Mat & img, int frame_count) = 0;
 
+  // 与detect相同，但结果连续存储在检测器持有的arena中，下一次detect前有效，不产生逐装甲板的堆分配
+  virtual const ArmorSet & detect_set(const cv::Mat & img, int frame_count) = 0;
+
+  // 提交一帧进行异步推理，所有infer request都在推理中时返回false，需先collect
+  // 空图像不推理但同样返回true，对应的collect结果中armors为空
+  virtual bool detect_async(const cv::Mat & img, int frame_count) = 0;
+
+  // 按提交顺序取回最早一帧的结果，没有在途帧时返回空
+  virtual std::optional<Result> collect() = 0;
+
+  // 多张图像(多相机或多个ROI)合并为一个batch推理，按输入顺序返回映射回原图的结果
+  virtual std::vector<std::list<Armor>> detect_batch(
+    const std::vector<cv::Mat> & imgs, int frame_count) = 0;
+
+  // 级联检测的粗检：以最小输入尺寸扫描全图
+  virtual std::list<Armor> detect_coarse(const cv::Mat & img, int frame_count) = 0;
+
+  // 级联检测的精检：在原图的多个裁剪区域上批量推理，按区域返回映射回原图的结果
+  virtual std::vector<std::list<Armor>> detect_regions(
+    const cv::Mat & img, const std::vector<cv::Rect> & rois, int frame_count) = 0;
 };
 
 class YOLO
@@ -21,10 +57,26 @@ public:
 
   std::list<Armor> detect(const cv::Mat & img, int frame_count = -1);
 
+  const ArmorSet & detect_set(const cv::Mat & img, int frame_count = -1);
+
+  bool detect_async(const cv::Mat & img, int frame_count);
+
+  std::optional<YOLOBase::Result> collect();
+
+  std::vector<std::list<Armor>> detect_batch(const std::vector<cv::Mat> & imgs, int frame_count = -1);
+
 private:
   std::unique_ptr<YOLOBase> yolo_;
+
+  bool cascade_;
+  int cascade_crop_size_;
+  std::size_t cascade_max_crops_;
+  ArmorSet cascade_armors_;  // 级联检测结果转换后的arena
+  std::deque<YOLOBase::Result> cascade_results_;  // 级联检测时异步接口同步完成，结果等待collect
+
+  std::list<Armor> detect_cascade(const cv::Mat & img, int frame_count);
 };
 
 }  // namespace auto_aim
 
-#endif  // AUTO_AIM__YOLO_HPP
\ No newline at end of file
+#endif  // AUTO_AIM__YOLO_HPP
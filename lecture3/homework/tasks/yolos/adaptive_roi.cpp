@@ -0,0 +1,60 @@
+#include "adaptive_roi.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace auto_aim
+{
+// 异步流水线下ROI要覆盖提交后约两帧的运动
+constexpr double MOTION_FRAMES = 2.0;
+
+AdaptiveROI::AdaptiveROI(double margin, int min_size, int max_lost_frames)
+: margin_(margin), min_size_(min_size), max_lost_frames_(max_lost_frames)
+{
+}
+
+void AdaptiveROI::update(const ArmorSet & armors, const cv::Size & img_size)
+{
+  if (armors.empty()) {
+    if (++lost_frames_ > max_lost_frames_) tracking_ = false;
+    return;
+  }
+
+  // 所有装甲板关键点的外接框
+  float min_x = armors[0].points[0].x, max_x = min_x;
+  float min_y = armors[0].points[0].y, max_y = min_y;
+  for (const auto & armor : armors) {
+    for (const auto & point : armor.points) {
+      min_x = std::min(min_x, point.x);
+      max_x = std::max(max_x, point.x);
+      min_y = std::min(min_y, point.y);
+      max_y = std::max(max_y, point.y);
+    }
+  }
+
+  cv::Point2f center((min_x + max_x) / 2, (min_y + max_y) / 2);
+  velocity_ = tracking_ ? center - center_ : cv::Point2f(0, 0);
+  center_ = center;
+  tracking_ = true;
+  lost_frames_ = 0;
+
+  // 边长随目标尺寸和运动速度放大，并预测下一帧的中心
+  auto target_size = std::max(max_x - min_x, max_y - min_y);
+  auto motion = MOTION_FRAMES * cv::norm(velocity_);
+  auto side = static_cast<int>(std::max<double>(target_size * margin_ + 2 * motion, min_size_));
+  auto width = std::min(side, img_size.width);
+  auto height = std::min(side, img_size.height);
+
+  auto predicted = center_ + velocity_;
+  auto x = std::clamp(static_cast<int>(predicted.x) - width / 2, 0, img_size.width - width);
+  auto y = std::clamp(static_cast<int>(predicted.y) - height / 2, 0, img_size.height - height);
+  roi_ = cv::Rect(x, y, width, height);
+}
+
+std::optional<cv::Rect> AdaptiveROI::roi() const
+{
+  if (!tracking_) return std::nullopt;
+  return roi_;
+}
+
+}  // namespace auto_aim
@@ -0,0 +1,36 @@
+#ifndef AUTO_AIM__ADAPTIVE_ROI_HPP
+#define AUTO_AIM__ADAPTIVE_ROI_HPP
+
+#include <opencv2/opencv.hpp>
+#include <optional>
+
+#include "tasks/armor_set.hpp"
+
+namespace auto_aim
+{
+// 以上一帧识别到的装甲板为中心的自适应裁剪区域，按原始分辨率裁剪送入网络
+class AdaptiveROI
+{
+public:
+  AdaptiveROI(double margin, int min_size, int max_lost_frames);
+
+  // 用一帧的识别结果更新跟踪状态，img_size为原图尺寸
+  void update(const ArmorSet & armors, const cv::Size & img_size);
+
+  // 下一帧的裁剪区域，连续max_lost_frames帧未识别后返回空，即使用全图
+  std::optional<cv::Rect> roi() const;
+
+private:
+  double margin_;        // 裁剪边长相对装甲板尺寸的倍数
+  int min_size_;         // 裁剪最小边长(像素)
+  int max_lost_frames_;  // 连续丢失多少帧后回到全图
+
+  bool tracking_ = false;
+  int lost_frames_ = 0;
+  cv::Point2f center_, velocity_;  // 装甲板中心及其每帧位移(像素)
+  cv::Rect roi_;
+};
+
+}  // namespace auto_aim
+
+#endif  // AUTO_AIM__ADAPTIVE_ROI_HPP
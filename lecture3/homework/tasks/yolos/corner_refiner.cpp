@@ -0,0 +1,79 @@
+#include "corner_refiner.hpp"
+
+#include <limits>
+#include <vector>
+
+namespace auto_aim
+{
+// 灯条长宽比下限，过滤装甲板图案等非灯条亮斑
+constexpr double MIN_LIGHTBAR_RATIO = 1.5;
+
+CornerRefiner::CornerRefiner(double binary_threshold, double max_offset_ratio)
+: binary_threshold_(binary_threshold), max_offset_ratio_(max_offset_ratio)
+{
+}
+
+std::optional<double> CornerRefiner::refine(const cv::Mat & bgr_img, ArmorDetection & armor) const
+{
+  // 关键点顺序为左上、右上、右下、左下，左侧灯条为0、3号点，右侧灯条为1、2号点
+  const cv::Point2f nn_tops[2] = {armor.points[0], armor.points[1]};
+  const cv::Point2f nn_bottoms[2] = {armor.points[3], armor.points[2]};
+
+  // 上下各扩展半个灯条长度，左右各扩展四分之一宽度，灯条端点偏出神经网络角点时也在ROI内
+  float min_x = armor.points[0].x, max_x = min_x;
+  float min_y = armor.points[0].y, max_y = min_y;
+  for (const auto & point : armor.points) {
+    min_x = std::min(min_x, point.x);
+    max_x = std::max(max_x, point.x);
+    min_y = std::min(min_y, point.y);
+    max_y = std::max(max_y, point.y);
+  }
+  auto pad_x = (max_x - min_x) / 4, pad_y = (max_y - min_y) / 2;
+  cv::Rect roi(
+    cv::Point(min_x - pad_x, min_y - pad_y), cv::Point(max_x + pad_x + 1, max_y + pad_y + 1));
+  roi &= cv::Rect(0, 0, bgr_img.cols, bgr_img.rows);
+  if (roi.empty()) return std::nullopt;
+
+  cv::Mat gray, binary;
+  cv::cvtColor(bgr_img(roi), gray, cv::COLOR_BGR2GRAY);
+  cv::threshold(gray, binary, binary_threshold_, 255, cv::THRESH_BINARY);
+
+  std::vector<std::vector<cv::Point>> contours;
+  cv::findContours(binary, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_NONE);
+
+  // 左右两侧分别选中心离神经网络估计最近的灯条
+  std::optional<Lightbar> best[2];
+  double best_distance[2] = {
+    std::numeric_limits<double>::max(), std::numeric_limits<double>::max()};
+  cv::Point2f offset = roi.tl();
+  for (const auto & contour : contours) {
+    if (contour.size() < 5) continue;
+
+    Lightbar lightbar(cv::minAreaRect(contour), 0);
+    if (lightbar.ratio < MIN_LIGHTBAR_RATIO) continue;
+    lightbar.center += offset;
+    lightbar.top += offset;
+    lightbar.bottom += offset;
+
+    for (int side = 0; side < 2; side++) {
+      auto nn_center = (nn_tops[side] + nn_bottoms[side]) / 2;
+      auto nn_length = cv::norm(nn_tops[side] - nn_bottoms[side]);
+      auto distance = cv::norm(lightbar.center - nn_center);
+      if (distance > max_offset_ratio_ * nn_length || distance >= best_distance[side]) continue;
+      best[side] = lightbar;
+      best_distance[side] = distance;
+    }
+  }
+  if (!best[0] || !best[1] || best[0]->center == best[1]->center) return std::nullopt;
+
+  const cv::Point2f refined[4] = {best[0]->top, best[1]->top, best[1]->bottom, best[0]->bottom};
+  double correction = 0;
+  for (int i = 0; i < 4; i++) {
+    correction += cv::norm(refined[i] - armor.points[i]);
+    armor.points[i] = refined[i];
+  }
+  armor.center = (armor.points[0] + armor.points[1] + armor.points[2] + armor.points[3]) / 4;
+  return correction / 4;
+}
+
+}  // namespace auto_aim
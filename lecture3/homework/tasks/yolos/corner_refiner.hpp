@@ -0,0 +1,28 @@
+#ifndef AUTO_AIM__CORNER_REFINER_HPP
+#define AUTO_AIM__CORNER_REFINER_HPP
+
+#include <opencv2/opencv.hpp>
+#include <optional>
+
+#include "tasks/armor.hpp"
+
+namespace auto_aim
+{
+// 传统方法二次矫正角点：只在装甲板附近的ROI内二值化找灯条，用灯条端点替换神经网络的角点
+class CornerRefiner
+{
+public:
+  CornerRefiner(double binary_threshold, double max_offset_ratio);
+
+  // 左右两根灯条都找到时修改armor的关键点和中心，返回关键点的平均修正量(像素)，否则返回空且不修改armor
+  // 只读bgr_img，可以在多个线程中对不同的装甲板并行调用
+  std::optional<double> refine(const cv::Mat & bgr_img, ArmorDetection & armor) const;
+
+private:
+  double binary_threshold_;
+  double max_offset_ratio_;  // 灯条中心与神经网络估计的最大偏差，相对灯条长度
+};
+
+}  // namespace auto_aim
+
+#endif  // AUTO_AIM__CORNER_REFINER_HPP
@@ -0,0 +1,154 @@
+#ifndef AUTO_AIM__YOLO_DECODER_HPP
+#define AUTO_AIM__YOLO_DECODER_HPP
+
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <cmath>
+#include <numeric>
+#include <opencv2/core/hal/intrin.hpp>
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+namespace auto_aim
+{
+/**
+ * 网络输出的行布局，每个模型一个，全部为编译期常量。
+ * 新增YOLO变体时只需添加一个布局，解码器的循环按布局在编译期展开。
+ */
+struct YOLOV5Layout
+{
+  static constexpr int row_width = 22;
+  static constexpr int score_col = 8;                 // objectness，sigmoid之前的logit
+  static constexpr int color_col = 9, color_num = 4;  // 颜色独热向量
+  static constexpr int class_col = 13, class_num = 9;  // 类别独热向量
+
+  // 网络按左上、左下、右下、右上输出关键点，解码后的顺序为左上、右上、右下、左下，
+  // 与Armor一致；依次为每个解码后关键点的(x, y)所在列
+  static constexpr int keypoint_num = 4;
+  static constexpr std::array<int, keypoint_num * 2> keypoint_cols = {0, 1, 6, 7, 4, 5, 2, 3};
+};
+
+// YOLO输出解码：objectness直接与反sigmoid后的阈值比较，被拒绝的行不需要计算exp
+template <typename Layout>
+class YOLODecoder
+{
+public:
+  static constexpr int color_num = Layout::color_num, class_num = Layout::class_num;
+
+  struct Candidate
+  {
+    int color_id;
+    int num_id;
+    float confidence;
+    cv::Rect box;
+    std::array<cv::Point2f, Layout::keypoint_num> keypoints;
+  };
+
+  // 按(颜色, 类别)的argmax索引的有效性表，下标为color_id * class_num + num_id
+  using ValidTable = std::array<bool, color_num * class_num>;
+
+  explicit YOLODecoder(float score_threshold)
+  : logit_threshold_(std::log(score_threshold / (1.0f - score_threshold)))
+  {
+    valid_.fill(true);
+#if CV_SIMD
+    threshold_pattern_.fill(FLT_MAX);
+    for (int i = Layout::score_col; i < block_; i += Layout::row_width)
+      threshold_pattern_[i] = logit_threshold_;
+#endif
+  }
+
+  // 无效的(颜色, 类别)组合在求出argmax后立即丢弃，不计算关键点和外接框，默认全部有效
+  void set_valid_table(const ValidTable & valid) { valid_ = valid; }
+
+  // output: [N, row_width] 连续存储的网络输出，scale: letterbox缩放系数
+  // 返回的候选数组由解码器持有并复用，在下一次decode前有效，可以原地做NMS
+  std::vector<Candidate> & decode(const cv::Mat & output, double scale)
+  {
+    CV_Assert(
+      output.type() == CV_32F && output.isContinuous() && output.cols == Layout::row_width);
+
+    candidates_.clear();
+    const auto * data = output.ptr<float>();
+    const int rows = output.rows;
+    int r = 0;
+
+#if CV_SIMD
+    // 按lcm(行宽, lane数)分块连续加载，每块内只有objectness所在的lane阈值有效，
+    // 整块都没有lane越过阈值时直接跳过块内所有行
+    constexpr int block_rows = block_ / Layout::row_width;
+    for (; r + block_rows <= rows; r += block_rows) {
+      const float * p = data + static_cast<std::size_t>(r) * Layout::row_width;
+      cv::v_float32 hit = cv::vx_setzero_f32();
+      for (int k = 0; k < block_; k += cv::v_float32::nlanes)
+        hit = hit | (cv::vx_load(p + k) >= cv::vx_load(threshold_pattern_.data() + k));
+      if (!cv::v_check_any(hit)) continue;
+
+      for (int i = 0; i < block_rows; i++) {
+        const float * row = p + i * Layout::row_width;
+        if (row[Layout::score_col] >= logit_threshold_) decode_row(row, scale);
+      }
+    }
+#endif
+
+    for (; r < rows; r++) {
+      const float * row = data + static_cast<std::size_t>(r) * Layout::row_width;
+      if (row[Layout::score_col] >= logit_threshold_) decode_row(row, scale);
+    }
+
+    return candidates_;
+  }
+
+private:
+#if CV_SIMD
+  static constexpr int block_ = std::lcm(Layout::row_width, int(cv::v_float32::nlanes));
+  // 与输出行对齐的逐lane阈值，非objectness列为FLT_MAX
+  std::array<float, block_> threshold_pattern_;
+#endif
+
+  float logit_threshold_;
+  ValidTable valid_;
+  std::vector<Candidate> candidates_;
+
+  void decode_row(const float * row, double scale)
+  {
+    //颜色和类别独热向量，先查表剔除友方和无效组合
+    const float * colors = row + Layout::color_col;
+    const float * classes = row + Layout::class_col;
+    int color_id = std::max_element(colors, colors + color_num) - colors;
+    int num_id = std::max_element(classes, classes + class_num) - classes;
+    if (!valid_[color_id * class_num + num_id]) return;
+
+    Candidate candidate;
+    candidate.confidence = 1.0f / (1.0f + std::exp(-row[Layout::score_col]));
+    candidate.color_id = color_id;
+    candidate.num_id = num_id;
+
+    for (int i = 0; i < Layout::keypoint_num; i++) {
+      candidate.keypoints[i] = cv::Point2f(
+        row[Layout::keypoint_cols[i * 2]] / scale, row[Layout::keypoint_cols[i * 2 + 1]] / scale);
+    }
+
+    float min_x = candidate.keypoints[0].x;
+    float max_x = candidate.keypoints[0].x;
+    float min_y = candidate.keypoints[0].y;
+    float max_y = candidate.keypoints[0].y;
+
+    for (int i = 1; i < Layout::keypoint_num; i++) {
+      min_x = std::min(min_x, candidate.keypoints[i].x);
+      max_x = std::max(max_x, candidate.keypoints[i].x);
+      min_y = std::min(min_y, candidate.keypoints[i].y);
+      max_y = std::max(max_y, candidate.keypoints[i].y);
+    }
+
+    candidate.box = cv::Rect(min_x, min_y, max_x - min_x, max_y - min_y);
+    candidates_.emplace_back(candidate);
+  }
+};
+
+using YOLOV5Decoder = YOLODecoder<YOLOV5Layout>;
+
+}  // namespace auto_aim
+
+#endif  // AUTO_AIM__YOLO_DECODER_HPP
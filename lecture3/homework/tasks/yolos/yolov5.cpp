@@ -3,15 +3,19 @@
 #include <fmt/chrono.h>
 #include <yaml-cpp/yaml.h>
 
-#include <filesystem>
+#include <algorithm>
+#include <limits>
+#include <openvino/opsets/opset8.hpp>
 
-#include "tools/img_tools.hpp"
 #include "tools/logger.hpp"
+#include "tools/nms.hpp"
+#include "tools/sample_dumper.hpp"
+#include "tools/worker_pool.hpp"
 
 namespace auto_aim
 {
 YOLOV5::YOLOV5(const std::string & config_path, bool debug)
-: debug_(debug)
+: debug_(debug), decoder_(score_threshold_)
 {
   auto yaml = YAML::LoadFile(config_path);
 
@@ -26,18 +30,301 @@ YOLOV5::YOLOV5(const std::string & config_path, bool debug)
   height = yaml["roi"]["height"].as<int>();
   use_roi_ = yaml["use_roi"].as<bool>();
   use_traditional_ = yaml["use_traditional"].as<bool>();
+  merge_keypoints_ = yaml["nms_merge_keypoints"].as<bool>();
+  decoder_.set_valid_table(make_valid_table(yaml["enemy_color"].as<std::string>()));
   roi_ = cv::Rect(x, y, width, height);
-  offset_ = cv::Point2f(x, y);
 
-  save_path_ = "imgs";
-  std::filesystem::create_directory(save_path_);
+  if (yaml["adaptive_roi"].as<bool>()) {
+    adaptive_roi_ = std::make_unique<AdaptiveROI>(
+      yaml["adaptive_roi_margin"].as<double>(), yaml["adaptive_roi_min_size"].as<int>(),
+      yaml["adaptive_roi_lost_frames"].as<int>());
+  }
+
+  // 传统方法二次矫正角点，按装甲板分给工作线程并行
+  if (use_traditional_) {
+    refiner_ = std::make_unique<CornerRefiner>(
+      binary_threshold_, yaml["traditional_max_offset"].as<double>());
+    refine_pool_ = std::make_unique<tools::WorkerPool>(yaml["traditional_workers"].as<int>());
+  }
+
+  min_armor_pixels_ = yaml["min_armor_pixels"].as<double>();
+  auto input_sizes = yaml["input_sizes"].as<std::vector<int>>();
+  auto output_top_k = yaml["output_top_k"].as<int>();
+  auto infer_requests = yaml["infer_requests"].as<int>();
+  if (input_sizes.empty()) throw std::runtime_error("input_sizes must not be empty!");
+  if (infer_requests < 1) throw std::runtime_error("infer_requests must be positive!");
+  std::sort(input_sizes.begin(), input_sizes.end());
+
+  // 编译缓存和mmap加载权重，缩短崩溃重启后的启动时间
+  auto cache_dir = yaml["cache_dir"].as<std::string>();
+  if (!cache_dir.empty()) core_.set_property(ov::cache_dir(cache_dir));
+  core_.set_property(ov::enable_mmap(true));
+
+  compile_config_ = make_compile_config(yaml);
+
+  auto ms_since = [](std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+      .count();
+  };
+
+  // 在当前CPU上从多个精度的IR中挑选最快且与参考模型结果一致的一个，
+  // 比对时已按最大输入尺寸编译过，胜出的编译结果直接给最大的variant使用
+  auto select_start = std::chrono::steady_clock::now();
+  std::optional<ov::CompiledModel> selected;
+  model_path_ = select_model(yaml, input_sizes.back(), output_top_k, selected);
+  auto select_ms = ms_since(select_start);
+
+  // 同一个模型按每个输入尺寸分别reshape并编译，各自持有infer request池
+  auto read_start = std::chrono::steady_clock::now();
   auto model = core_.read_model(model_path_);
+  auto read_ms = ms_since(read_start);
+
+  auto compile_start = std::chrono::steady_clock::now();
+  variants_.resize(input_sizes.size());
+  for (std::size_t i = 0; i < input_sizes.size(); i++) {
+    auto & variant = variants_[i];
+    variant.input_size = input_sizes[i];
+    if (variant.input_size <= 0 || variant.input_size % 32 != 0)
+      throw std::runtime_error(fmt::format("Invalid input size: {}!", variant.input_size));
+
+    if (selected && variant.input_size == input_sizes.back()) {
+      variant.compiled_model = std::move(*selected);
+      selected.reset();
+    } else {
+      variant.compiled_model = core_.compile_model(
+        build_model(model->clone(), 1, variant.input_size, output_top_k), device_,
+        compile_config_);
+    }
+
+    variant.slots.resize(infer_requests);
+    for (auto & slot : variant.slots) {
+      slot.request = variant.compiled_model.create_infer_request();
+      auto input_tensor = slot.request.get_input_tensor();
+      slot.input = cv::Mat(variant.input_size, variant.input_size, CV_8UC3, input_tensor.data());
+
+      // 推理完成时记录时间，用于统计各输入尺寸的延迟
+      auto * slot_ptr = &slot;
+      slot.request.set_callback([slot_ptr](std::exception_ptr) {
+        slot_ptr->end = std::chrono::steady_clock::now();
+      });
+    }
+  }
+
+  // 多图批量推理，输入尺寸与最大的variant一致
+  auto batch_size = yaml["batch_size"].as<int>();
+  if (batch_size > 1)
+    batch_ = make_batch_slot(model, batch_size, variants_.back().input_size, output_top_k);
+
+  // 级联检测的精检阶段：以原始分辨率的裁剪区域为输入，多个区域合并为一个batch
+  if (yaml["cascade"].as<bool>()) {
+    refine_ = make_batch_slot(
+      model, yaml["cascade_max_crops"].as<int>(), yaml["cascade_crop_size"].as<int>(),
+      output_top_k);
+  }
+  auto compile_ms = ms_since(compile_start);
+
+  // 后台保存不确定的图案，放在精度选择之后，避免保存启动时的比对样本
+  if (yaml["sample_dump"].as<bool>()) {
+    dumper_ = std::make_unique<tools::SampleDumper>(
+      yaml["sample_dump_dir"].as<std::string>(), yaml["sample_dump_queue"].as<std::size_t>(),
+      yaml["sample_dump_workers"].as<int>(), yaml["sample_dump_interval"].as<double>(),
+      yaml["sample_dump_quota_mb"].as<std::size_t>());
+  }
+
+  // 预热：首次推理的延迟初始化放在构造函数里完成
+  auto warmup_start = std::chrono::steady_clock::now();
+  auto warmup_iterations = yaml["warmup_iterations"].as<int>();
+  for (int i = 0; i < warmup_iterations; i++) {
+    for (auto & variant : variants_) {
+      for (auto & slot : variant.slots) slot.request.infer();
+    }
+    if (batch_) batch_->request.infer();
+    if (refine_) refine_->request.infer();
+  }
+  auto warmup_ms = ms_since(warmup_start);
+
+  tools::logger()->info(
+    "[YOLOV5] select {:.1f} ms, read {:.1f} ms, compile {:.1f} ms, warm-up {:.1f} ms ({} "
+    "iterations)",
+    select_ms, read_ms, compile_ms, warmup_ms, warmup_iterations);
+}
+
+YOLOV5::~YOLOV5()
+{
+  for (const auto & stats : variant_stats()) {
+    tools::logger()->info(
+      "[YOLOV5] input {}: picked {} times, {:.2f} ms/frame", stats.input_size, stats.picks,
+      stats.mean_latency_ms);
+  }
+
+  if (refiner_) {
+    auto stats = refine_stats();
+    tools::logger()->info(
+      "[YOLOV5] corner refinement: {}/{} armors, {:.2f} px mean correction", stats.refined,
+      stats.attempts, stats.mean_correction_px);
+  }
+}
+
+ov::AnyMap YOLOV5::make_compile_config(const YAML::Node & yaml)
+{
+  ov::AnyMap config;
+
+  auto mode = yaml["performance_mode"].as<std::string>();
+  if (mode == "LATENCY")
+    config.insert(ov::hint::performance_mode(ov::hint::PerformanceMode::LATENCY));
+  else if (mode == "THROUGHPUT")
+    config.insert(ov::hint::performance_mode(ov::hint::PerformanceMode::THROUGHPUT));
+  else if (mode == "CUMULATIVE_THROUGHPUT")
+    config.insert(ov::hint::performance_mode(ov::hint::PerformanceMode::CUMULATIVE_THROUGHPUT));
+  else
+    throw std::runtime_error("Unknown performance_mode: " + mode + "!");
+
+  // -1 表示由performance_mode决定
+  auto num_streams = yaml["num_streams"].as<int>();
+  if (num_streams >= 0) config.insert(ov::num_streams(num_streams));
+
+  // 0 表示由OpenVINO决定
+  auto inference_threads = yaml["inference_threads"].as<int>();
+  if (inference_threads > 0) config.insert(ov::inference_num_threads(inference_threads));
+
+  // 留空使用设备默认精度，例如f32/bf16/f16
+  auto precision = yaml["inference_precision"].as<std::string>();
+  if (!precision.empty())
+    config.insert(ov::hint::inference_precision(ov::element::Type(precision)));
+
+  auto core_type = yaml["scheduling_core_type"].as<std::string>();
+  if (core_type == "ANY_CORE")
+    config.insert(ov::hint::scheduling_core_type(ov::hint::SchedulingCoreType::ANY_CORE));
+  else if (core_type == "PCORE_ONLY")
+    config.insert(ov::hint::scheduling_core_type(ov::hint::SchedulingCoreType::PCORE_ONLY));
+  else if (core_type == "ECORE_ONLY")
+    config.insert(ov::hint::scheduling_core_type(ov::hint::SchedulingCoreType::ECORE_ONLY));
+  else
+    throw std::runtime_error("Unknown scheduling_core_type: " + core_type + "!");
+
+  tools::logger()->info(
+    "[YOLOV5] {} num_streams={} threads={} precision={} core={}", mode, num_streams,
+    inference_threads, precision.empty() ? "default" : precision, core_type);
+  return config;
+}
+
+std::string YOLOV5::select_model(
+  const YAML::Node & yaml, int input_size, int output_top_k,
+  std::optional<ov::CompiledModel> & compiled_model)
+{
+  // 第一个为参考模型(通常是FP32)，其余为FP16/INT8等候选
+  std::vector<std::string> paths = {model_path_};
+  for (const auto & path : yaml["yolov5_model_variants"].as<std::vector<std::string>>())
+    paths.push_back(path);
+  if (paths.size() == 1) return model_path_;
+
+  std::vector<cv::Mat> samples;
+  for (const auto & path : yaml["precision_samples"].as<std::vector<std::string>>()) {
+    auto img = cv::imread(path);
+    if (img.empty())
+      tools::logger()->warn("[YOLOV5] Failed to read precision sample {}", path);
+    else
+      samples.push_back(img);
+  }
+  if (samples.empty()) {
+    tools::logger()->warn("[YOLOV5] No precision samples, use {}", model_path_);
+    return model_path_;
+  }
+
+  auto iterations = yaml["precision_benchmark_iterations"].as<int>();
+  auto min_agreement = yaml["precision_min_agreement"].as<double>();
+
+  using Detections = std::vector<std::list<Armor>>;
+
+  // 在样本上推理，返回每张样本的识别结果和中位推理延迟，编译结果通过compiled带出
+  auto run = [&](
+               const std::string & path, Detections & detections, ov::CompiledModel & compiled) {
+    compiled = core_.compile_model(
+      build_model(core_.read_model(path), 1, input_size, output_top_k), device_, compile_config_);
+    auto request = compiled.create_infer_request();
+    cv::Mat input(input_size, input_size, CV_8UC3, request.get_input_tensor().data());
+    cv::Size valid_size;
+
+    for (const auto & sample : samples) {
+      auto scale = letterbox(sample, input_size, input, valid_size);
+      request.infer();
+      auto output_tensor = request.get_output_tensor();
+      auto output_shape = output_tensor.get_shape();
+      cv::Mat output(output_shape[1], output_shape[2], CV_32F, output_tensor.data());
+      ArmorSet armors;
+      parse(scale, output, sample, cv::Rect(0, 0, sample.cols, sample.rows), -1, armors);
+      detections.push_back(armors.to_list());
+    }
+
+    std::vector<double> latencies;
+    for (int i = 0; i < iterations; i++) {
+      letterbox(samples[i % samples.size()], input_size, input, valid_size);
+      auto start = std::chrono::steady_clock::now();
+      request.infer();
+      latencies.push_back(
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+          .count());
+    }
+    if (latencies.empty()) return 0.0;
+    std::nth_element(
+      latencies.begin(), latencies.begin() + latencies.size() / 2, latencies.end());
+    return latencies[latencies.size() / 2];
+  };
+
+  // 一致率：与参考结果同颜色同图案且框重叠的装甲板占两者中较多一方数量的比例
+  auto agreement = [](const Detections & reference, const Detections & detections) {
+    std::size_t matched = 0, total = 0;
+    for (std::size_t i = 0; i < reference.size(); i++) {
+      total += std::max(reference[i].size(), detections[i].size());
+      for (const auto & ref : reference[i]) {
+        auto ref_box = cv::boundingRect(ref.points);
+        matched += std::any_of(detections[i].begin(), detections[i].end(), [&](const Armor & a) {
+          return a.color == ref.color && a.name == ref.name &&
+                 tools::iou(ref_box, cv::boundingRect(a.points)) > 0.5f;
+        });
+      }
+    }
+    return total > 0 ? static_cast<double>(matched) / total : 1.0;
+  };
+
+  Detections reference;
+  ov::CompiledModel best_compiled;
+  auto best_ms = run(paths.front(), reference, best_compiled);
+  auto best_path = paths.front();
+  tools::logger()->info("[YOLOV5] {}: {:.2f} ms (reference)", best_path, best_ms);
+
+  for (std::size_t i = 1; i < paths.size(); i++) {
+    Detections detections;
+    ov::CompiledModel compiled;
+    auto ms = run(paths[i], detections, compiled);
+    auto ratio = agreement(reference, detections);
+    auto accepted = ratio >= min_agreement;
+    tools::logger()->info(
+      "[YOLOV5] {}: {:.2f} ms, agreement {:.2f}{}", paths[i], ms, ratio,
+      accepted ? "" : " (rejected)");
+    if (accepted && ms < best_ms) {
+      best_ms = ms;
+      best_path = paths[i];
+      best_compiled = std::move(compiled);
+    }
+  }
+
+  tools::logger()->info("[YOLOV5] Selected {}", best_path);
+  compiled_model = std::move(best_compiled);
+  return best_path;
+}
+
+std::shared_ptr<ov::Model> YOLOV5::build_model(
+  std::shared_ptr<ov::Model> model, int batch, int input_size, int output_top_k) const
+{
+  model->reshape(ov::PartialShape{batch, 3, input_size, input_size});
+
   ov::preprocess::PrePostProcessor ppp(model);
   auto & input = ppp.input();
 
   input.tensor()
     .set_element_type(ov::element::u8)
-    .set_shape({1, 640, 640, 3})
+    .set_shape({batch, input_size, input_size, 3})
     .set_layout("NHWC")
     .set_color_format(ov::preprocess::ColorFormat::BGR);
 
@@ -48,20 +335,241 @@ YOLOV5::YOLOV5(const std::string & config_path, bool debug)
     .convert_color(ov::preprocess::ColorFormat::RGB)
     .scale(255.0);
 
-  // TODO: ov::hint::performance_mode(ov::hint::PerformanceMode::LATENCY)
-  model = ppp.build();
-  compiled_model_ = core_.compile_model(
-    model, device_, ov::hint::performance_mode(ov::hint::PerformanceMode::LATENCY));
+  // 输出后处理：在图内按objectness阈值筛选并取top-K行，主机端解码量与anchor数无关
+  if (output_top_k > 0) {
+    auto logit_threshold = std::log(score_threshold_ / (1.0f - score_threshold_));
+    ppp.output().postprocess().custom([=](const ov::Output<ov::Node> & node) {
+      using namespace ov::opset8;
+      auto i64 = [](const std::vector<int64_t> & values) {
+        return Constant::create(ov::element::i64, ov::Shape{values.size()}, values);
+      };
+      auto f32 = [](float value) { return Constant::create(ov::element::f32, ov::Shape{}, {value}); };
+
+      // [B, N, 22] -> [B, N]
+      auto score = std::make_shared<Squeeze>(
+        std::make_shared<Slice>(node, i64({8}), i64({9}), i64({1}), i64({2})), i64({2}));
+      auto masked = std::make_shared<Select>(
+        std::make_shared<Greater>(score, f32(logit_threshold)), score,
+        f32(-std::numeric_limits<float>::infinity()));
+      auto top_k = std::make_shared<TopK>(
+        masked, Constant::create(ov::element::i64, ov::Shape{}, {output_top_k}), 1, "max", "value");
+
+      // [B, N, 22] -> [B, K, 22]，按objectness降序
+      auto axis = Constant::create(ov::element::i64, ov::Shape{}, {1});
+      auto rows = std::make_shared<Gather>(node, top_k->output(1), axis, 1);
+      return rows->output(0);
+    });
+  }
+
+  return ppp.build();
+}
+
+std::unique_ptr<YOLOV5::BatchSlot> YOLOV5::make_batch_slot(
+  const std::shared_ptr<ov::Model> & model, int batch, int input_size, int output_top_k)
+{
+  if (batch < 1 || input_size <= 0 || input_size % 32 != 0)
+    throw std::runtime_error(fmt::format("Invalid batch {} or input size {}!", batch, input_size));
+
+  auto slot = std::make_unique<BatchSlot>();
+  slot->batch = batch;
+  slot->input_size = input_size;
+  slot->compiled_model = core_.compile_model(
+    build_model(model->clone(), batch, input_size, output_top_k), device_, compile_config_);
+  slot->request = slot->compiled_model.create_infer_request();
+
+  auto * data = static_cast<uint8_t *>(slot->request.get_input_tensor().data());
+  for (int i = 0; i < batch; i++) {
+    auto offset = static_cast<std::size_t>(i) * input_size * input_size * 3;
+    slot->inputs.emplace_back(input_size, input_size, CV_8UC3, data + offset);
+  }
+  slot->letterboxes.resize(batch);
+  return slot;
 }
 
 std::list<Armor> YOLOV5::detect(const cv::Mat & raw_img, int frame_count)
 {
+  return detect_set(raw_img, frame_count).to_list();
+}
+
+const ArmorSet & YOLOV5::detect_set(const cv::Mat & raw_img, int frame_count)
+{
+  static const ArmorSet empty;
   if (raw_img.empty()) {
+    tools::logger()->warn("Empty img!, camera drop!");
+    return empty;
+  }
+
+  auto roi = select_roi(raw_img);
+  auto & variant = variants_[select_variant(roi)];
+
+  // 同步推理借用下一个空闲slot，不进入在途队列
+  if (variant.in_flight == variant.slots.size())
+    throw std::runtime_error("No idle infer request, collect() before detect()!");
+
+  auto & slot = variant.slots[variant.next_slot];
+  slot.frame_count = frame_count;
+  preprocess(raw_img, roi, variant.input_size, slot);
+  slot.start = std::chrono::steady_clock::now();
+  slot.request.infer();
+  slot.end = std::chrono::steady_clock::now();
+
+  return postprocess(variant, slot);
+}
+
+bool YOLOV5::detect_async(const cv::Mat & raw_img, int frame_count)
+{
+  if (raw_img.empty()) {
+    tools::logger()->warn("Empty img!, camera drop!");
+    in_flight_.push_back({Pending::dropped, Pending::dropped, frame_count});
+    return true;
+  }
+
+  auto roi = select_roi(raw_img);
+  auto variant_id = select_variant(roi);
+  auto & variant = variants_[variant_id];
+  if (variant.in_flight == variant.slots.size()) return false;
+
+  auto slot_id = variant.next_slot;
+  auto & slot = variant.slots[slot_id];
+  slot.frame_count = frame_count;
+  preprocess(raw_img, roi, variant.input_size, slot);
+  slot.start = std::chrono::steady_clock::now();
+  slot.request.start_async();
+
+  in_flight_.push_back({variant_id, slot_id, frame_count});
+  variant.in_flight++;
+  variant.next_slot = (variant.next_slot + 1) % variant.slots.size();
+  return true;
+}
+
+std::optional<YOLOBase::Result> YOLOV5::collect()
+{
+  if (in_flight_.empty()) return std::nullopt;
+
+  auto pending = in_flight_.front();
+  in_flight_.pop_front();
+  if (pending.variant == Pending::dropped) return Result{pending.frame_count, cv::Mat(), {}};
+
+  auto & variant = variants_[pending.variant];
+  auto & slot = variant.slots[pending.slot];
+  slot.request.wait();
+  variant.in_flight--;
+
+  Result result{slot.frame_count, slot.raw_img, postprocess(variant, slot).to_list()};
+  slot.raw_img.release();
+  return result;
+}
+
+std::vector<std::list<Armor>> YOLOV5::detect_batch(
+  const std::vector<cv::Mat> & imgs, int frame_count)
+{
+  // 未启用批量推理时逐张同步推理
+  if (!batch_) {
+    std::vector<std::list<Armor>> results;
+    for (const auto & img : imgs) results.emplace_back(detect(img, frame_count));
+    return results;
+  }
+
+  std::vector<std::list<Armor>> results(imgs.size());
+  std::vector<cv::Mat> valid_imgs;
+  std::vector<cv::Rect> rois;
+  std::vector<std::size_t> indices;
+  for (std::size_t i = 0; i < imgs.size(); i++) {
+    if (imgs[i].empty()) {
+      tools::logger()->warn("Empty img!, camera drop!");
+      continue;
+    }
+    // 自适应ROI只跟踪单路画面，批量推理时只使用配置文件中的固定ROI
+    cv::Rect roi(0, 0, imgs[i].cols, imgs[i].rows);
+    if (use_roi_) {
+      roi.x = roi_.x;
+      roi.y = roi_.y;
+      if (roi_.width != -1) roi.width = roi_.width;
+      if (roi_.height != -1) roi.height = roi_.height;
+    }
+
+    valid_imgs.emplace_back(imgs[i]);
+    rois.emplace_back(roi);
+    indices.emplace_back(i);
+  }
+
+  auto batch_results = infer_batch(*batch_, valid_imgs, rois, frame_count);
+  for (std::size_t i = 0; i < indices.size(); i++) results[indices[i]] = std::move(batch_results[i]);
+  return results;
+}
+
+std::list<Armor> YOLOV5::detect_coarse(const cv::Mat & img, int frame_count)
+{
+  if (img.empty()) {
     tools::logger()->warn("Empty img!, camera drop!");
     return std::list<Armor>();
   }
 
-  cv::Mat bgr_img;
+  // 以最小输入尺寸扫描全图，不更新ROI跟踪状态
+  auto & variant = variants_.front();
+  if (variant.in_flight == variant.slots.size())
+    throw std::runtime_error("No idle infer request, collect() before detect()!");
+
+  auto & slot = variant.slots[variant.next_slot];
+  slot.frame_count = frame_count;
+  preprocess(img, cv::Rect(0, 0, img.cols, img.rows), variant.input_size, slot);
+  slot.start = std::chrono::steady_clock::now();
+  slot.request.infer();
+  slot.end = std::chrono::steady_clock::now();
+
+  return parse_slot(slot).to_list();
+}
+
+std::vector<std::list<Armor>> YOLOV5::detect_regions(
+  const cv::Mat & img, const std::vector<cv::Rect> & rois, int frame_count)
+{
+  if (!refine_) throw std::runtime_error("Cascade is not enabled, check yolo.yaml!");
+
+  std::vector<cv::Mat> imgs(rois.size(), img);
+  return infer_batch(*refine_, imgs, rois, frame_count);
+}
+
+std::vector<std::list<Armor>> YOLOV5::infer_batch(
+  BatchSlot & slot, const std::vector<cv::Mat> & imgs, const std::vector<cv::Rect> & rois,
+  int frame_count)
+{
+  std::vector<std::list<Armor>> results;
+  std::vector<double> scales(slot.batch);
+  for (std::size_t begin = 0; begin < imgs.size(); begin += slot.batch) {
+    auto n = std::min<std::size_t>(slot.batch, imgs.size() - begin);
+    for (std::size_t i = 0; i < n; i++) {
+      scales[i] = letterbox(
+        imgs[begin + i](rois[begin + i]), slot.input_size, slot.inputs[i], slot.letterboxes[i]);
+    }
+
+    slot.request.infer();
+
+    // [B, K, 22]，未使用的batch项直接忽略
+    auto output_tensor = slot.request.get_output_tensor();
+    auto output_shape = output_tensor.get_shape();
+    auto * data = output_tensor.data<float>();
+    for (std::size_t i = 0; i < n; i++) {
+      cv::Mat output(
+        output_shape[1], output_shape[2], CV_32F, data + i * output_shape[1] * output_shape[2]);
+      parse(scales[i], output, imgs[begin + i], rois[begin + i], frame_count, batch_armors_);
+      results.emplace_back(batch_armors_.to_list());
+    }
+  }
+  return results;
+}
+
+std::vector<YOLOV5::VariantStats> YOLOV5::variant_stats() const
+{
+  std::vector<VariantStats> stats;
+  for (const auto & variant : variants_) {
+    auto mean = variant.picks > 0 ? variant.total_latency_ms / variant.picks : 0.0;
+    stats.push_back({variant.input_size, variant.picks, mean});
+  }
+  return stats;
+}
+
+cv::Rect YOLOV5::select_roi(const cv::Mat & raw_img)
+{
   if (use_roi_) {
     if (roi_.width == -1) {  // -1 表示该维度不裁切
       roi_.width = raw_img.cols;
@@ -69,149 +577,188 @@ std::list<Armor> YOLOV5::detect(const cv::Mat & raw_img, int frame_count)
     if (roi_.height == -1) {  // -1 表示该维度不裁切
       roi_.height = raw_img.rows;
     }
-    bgr_img = raw_img(roi_);
-  } else {
-    bgr_img = raw_img;
   }
 
-  auto x_scale = static_cast<double>(640) / bgr_img.rows;
-  auto y_scale = static_cast<double>(640) / bgr_img.cols;
+  // 跟踪中优先使用自适应ROI，其次是配置文件中的固定ROI，否则使用全图
+  std::optional<cv::Rect> adaptive_roi;
+  if (adaptive_roi_) adaptive_roi = adaptive_roi_->roi();
+
+  if (adaptive_roi) return *adaptive_roi;
+  if (use_roi_) return roi_;
+  return cv::Rect(0, 0, raw_img.cols, raw_img.rows);
+}
+
+std::size_t YOLOV5::select_variant(const cv::Rect & roi) const
+{
+  // 上一帧没有识别结果时用最大的输入尺寸搜索
+  if (last_armor_pixels_ <= 0) return variants_.size() - 1;
+
+  // 选择能让最小的装甲板在网络输入中仍有min_armor_pixels高度的最小尺寸
+  auto crop_side = std::max(roi.width, roi.height);
+  for (std::size_t i = 0; i < variants_.size(); i++) {
+    if (last_armor_pixels_ * variants_[i].input_size / crop_side >= min_armor_pixels_) return i;
+  }
+  return variants_.size() - 1;
+}
+
+void YOLOV5::preprocess(
+  const cv::Mat & raw_img, const cv::Rect & roi, int input_size, InferSlot & slot)
+{
+  slot.scale = letterbox(raw_img(roi), input_size, slot.input, slot.letterbox);
+  slot.raw_img = raw_img;
+  slot.roi = roi;
+}
+
+double YOLOV5::letterbox(
+  const cv::Mat & bgr_img, int input_size, cv::Mat & input, cv::Size & valid_size)
+{
+  auto x_scale = static_cast<double>(input_size) / bgr_img.rows;
+  auto y_scale = static_cast<double>(input_size) / bgr_img.cols;
   auto scale = std::min(x_scale, y_scale);
   auto h = static_cast<int>(bgr_img.rows * scale);
   auto w = static_cast<int>(bgr_img.cols * scale);
 
-  // preproces
-  auto input = cv::Mat(640, 640, CV_8UC3, cv::Scalar(0, 0, 0));
-  auto roi = cv::Rect(0, 0, w, h);
-  cv::resize(bgr_img, input(roi), {w, h});
-  ov::Tensor input_tensor(ov::element::u8, {1, 640, 640, 3}, input.data);
+  // preproces: 直接缩放到输入张量的左上角，几何关系变化时才清零右侧和下方的填充带
+  if (valid_size != cv::Size(w, h)) {
+    input(cv::Rect(w, 0, input_size - w, h)).setTo(cv::Scalar::all(0));
+    input(cv::Rect(0, h, input_size, input_size - h)).setTo(cv::Scalar::all(0));
+    valid_size = cv::Size(w, h);
+  }
+
+  // dst与输入张量共享内存，尺寸和类型都已匹配，resize直接写入张量
+  auto dst = input(cv::Rect(0, 0, w, h));
+  cv::resize(bgr_img, dst, {w, h});
 
-  // infer
-  auto infer_request = compiled_model_.create_infer_request();
-  infer_request.set_input_tensor(input_tensor);
-  infer_request.infer();
+  return scale;
+}
 
-  // postprocess
-  auto output_tensor = infer_request.get_output_tensor();
+const ArmorSet & YOLOV5::parse_slot(InferSlot & slot)
+{
+  auto output_tensor = slot.request.get_output_tensor();
   auto output_shape = output_tensor.get_shape();
   cv::Mat output(output_shape[1], output_shape[2], CV_32F, output_tensor.data());
 
-  return parse(scale, output, raw_img, frame_count);
+  parse(slot.scale, output, slot.raw_img, slot.roi, slot.frame_count, slot.armors);
+  return slot.armors;
 }
 
-std::list<Armor> YOLOV5::parse(
-  double scale, cv::Mat & output, const cv::Mat & bgr_img, int frame_count)
+const ArmorSet & YOLOV5::postprocess(Variant & variant, InferSlot & slot)
 {
-  // for each row: xywh + classess
-  std::vector<int> color_ids, num_ids;
-  std::vector<float> confidences;
-  std::vector<cv::Rect> boxes;
-  std::vector<std::vector<cv::Point2f>> armors_key_points;
-  for (int r = 0; r < output.rows; r++) {
-    double score = output.at<float>(r, 8);
-    score = sigmoid(score);
-
-    if (score < score_threshold_) continue;
-
-    std::vector<cv::Point2f> armor_key_points;
-
-    //颜色和类别独热向量
-    cv::Mat color_scores = output.row(r).colRange(9, 13);     //color
-    cv::Mat classes_scores = output.row(r).colRange(13, 22);  //num
-    cv::Point class_id, color_id;
-    int _class_id, _color_id;
-    double score_color, score_num;
-    cv::minMaxLoc(classes_scores, NULL, &score_num, NULL, &class_id);
-    cv::minMaxLoc(color_scores, NULL, &score_color, NULL, &color_id);
-    _class_id = class_id.x;
-    _color_id = color_id.x;
-
-    armor_key_points.push_back(
-      cv::Point2f(output.at<float>(r, 0) / scale, output.at<float>(r, 1) / scale));
-    armor_key_points.push_back(
-      cv::Point2f(output.at<float>(r, 6) / scale, output.at<float>(r, 7) / scale));
-    armor_key_points.push_back(
-      cv::Point2f(output.at<float>(r, 4) / scale, output.at<float>(r, 5) / scale));
-    armor_key_points.push_back(
-      cv::Point2f(output.at<float>(r, 2) / scale, output.at<float>(r, 3) / scale));
-
-    float min_x = armor_key_points[0].x;
-    float max_x = armor_key_points[0].x;
-    float min_y = armor_key_points[0].y;
-    float max_y = armor_key_points[0].y;
-
-    for (int i = 1; i < armor_key_points.size(); i++) {
-      if (armor_key_points[i].x < min_x) min_x = armor_key_points[i].x;
-      if (armor_key_points[i].x > max_x) max_x = armor_key_points[i].x;
-      if (armor_key_points[i].y < min_y) min_y = armor_key_points[i].y;
-      if (armor_key_points[i].y > max_y) max_y = armor_key_points[i].y;
-    }
+  // 只统计按帧选择的推理，级联粗检固定使用最小尺寸，不计入
+  variant.picks++;
+  variant.total_latency_ms +=
+    std::chrono::duration<double, std::milli>(slot.end - slot.start).count();
 
-    cv::Rect rect(min_x, min_y, max_x - min_x, max_y - min_y);
+  const auto & armors = parse_slot(slot);
+  if (adaptive_roi_) adaptive_roi_->update(armors, slot.raw_img.size());
 
-    color_ids.emplace_back(_color_id);
-    num_ids.emplace_back(_class_id);
-    boxes.emplace_back(rect);
-    confidences.emplace_back(score);
-    armors_key_points.emplace_back(armor_key_points);
+  // 记录最小装甲板的像素高度，用于下一帧选择输入尺寸
+  last_armor_pixels_ = 0;
+  for (const auto & armor : armors) {
+    auto height = std::max(
+      cv::norm(armor.points[0] - armor.points[3]), cv::norm(armor.points[1] - armor.points[2]));
+    if (last_armor_pixels_ <= 0 || height < last_armor_pixels_) last_armor_pixels_ = height;
   }
 
-  std::vector<int> indices;
-  cv::dnn::NMSBoxes(boxes, confidences, score_threshold_, nms_threshold_, indices);
+  return armors;
+}
 
-  std::list<Armor> armors;
-  for (const auto & i : indices) {
-    if (use_roi_) {
-      armors.emplace_back(
-        color_ids[i], num_ids[i], confidences[i], boxes[i], armors_key_points[i], offset_);
-    } else {
-      armors.emplace_back(color_ids[i], num_ids[i], confidences[i], boxes[i], armors_key_points[i]);
-    }
-  }
+void YOLOV5::parse(
+  double scale, cv::Mat & output, const cv::Mat & bgr_img, const cv::Rect & roi, int frame_count,
+  ArmorSet & armors)
+{
+  auto & candidates = decoder_.decode(output, scale);
 
+  // 同一位置只保留一块装甲板，因此不区分类别
+  tools::nms(candidates, nms_threshold_, merge_keypoints_);
+
+  // 关键点从裁剪区域映射回原图，结果直接写入该帧的arena
+  cv::Point2f offset = roi.tl();
+  armors.clear();
   tmp_img_ = bgr_img;
-  for (auto it = armors.begin(); it != armors.end();) {
-    if (!check_name(*it)) {
-      it = armors.erase(it);
-      continue;
-    }
+  for (const auto & candidate : candidates) {
+    ArmorDetection armor(
+      candidate.color_id, candidate.num_id, candidate.confidence, candidate.box,
+      candidate.keypoints, offset);
+    if (!check_name(armor)) continue;
+    if (!check_type(armor)) continue;
+
+    armor.center_norm = get_center_norm(bgr_img, armor.center);
+    armors.push_back(armor);
+  }
 
-    if (!check_type(*it)) {
-      it = armors.erase(it);
-      continue;
-    }
-    // 使用传统方法二次矫正角点
-    // if (use_traditional_) detector_.detect(*it, bgr_img);
+  // 使用传统方法二次矫正角点：detect_async/collect流水线中与下一帧的推理同时进行，
+  // 同步detect时在推理之后串行执行
+  if (refiner_) refine_corners(bgr_img, armors);
+}
 
-    it->center_norm = get_center_norm(bgr_img, it->center);
-    ++it;
+void YOLOV5::refine_corners(const cv::Mat & bgr_img, ArmorSet & armors)
+{
+  corrections_.assign(armors.size(), std::nullopt);
+  refine_pool_->parallel_for(armors.size(), [&](std::size_t i) {
+    corrections_[i] = refiner_->refine(bgr_img, armors[i]);
+    if (corrections_[i]) armors[i].center_norm = get_center_norm(bgr_img, armors[i].center);
+  });
+
+  for (const auto & correction : corrections_) {
+    refine_attempts_++;
+    if (!correction) continue;
+    refined_++;
+    total_correction_px_ += *correction;
   }
+}
 
-  if (debug_) draw_detections(bgr_img, armors, frame_count);
+YOLOV5::RefineStats YOLOV5::refine_stats() const
+{
+  auto mean = refined_ > 0 ? total_correction_px_ / refined_ : 0.0;
+  return {refine_attempts_, refined_, mean};
+}
 
-  return armors;
+YOLOV5Decoder::ValidTable YOLOV5::make_valid_table(const std::string & enemy_color)
+{
+  if (enemy_color != "red" && enemy_color != "blue" && enemy_color != "all")
+    throw std::runtime_error("Unknown enemy_color: " + enemy_color + "!");
+
+  // 只丢弃己方颜色和非装甲板，熄灭和紫色的装甲板不属于任何一方，照常保留；
+  // 图案与大小不匹配的组合留给check_type处理，以便保存这类异常样本
+  auto friendly_color = enemy_color == "red" ? "blue" : "red";
+  YOLOV5Decoder::ValidTable valid;
+  for (int color_id = 0; color_id < YOLOV5Decoder::color_num; color_id++) {
+    for (int num_id = 0; num_id < YOLOV5Decoder::class_num; num_id++) {
+      auto color = std::get<Color>(yolov5_properties(color_id, num_id));
+      auto name = std::get<ArmorName>(yolov5_properties(color_id, num_id));
+      auto color_ok = enemy_color == "all" || COLORS[color] != friendly_color;
+      auto name_ok = name != ArmorName::not_armor;
+      valid[color_id * YOLOV5Decoder::class_num + num_id] = color_ok && name_ok;
+    }
+  }
+  return valid;
 }
 
-bool YOLOV5::check_name(const Armor & armor) const
+bool YOLOV5::valid_type(ArmorName name, ArmorType type)
+{
+  return (type == ArmorType::small)
+           ? (name != ArmorName::one && name != ArmorName::base)
+           : (name != ArmorName::two && name != ArmorName::sentry && name != ArmorName::outpost);
+}
+
+bool YOLOV5::check_name(const ArmorDetection & armor) const
 {
   auto name_ok = armor.name != ArmorName::not_armor;
   auto confidence_ok = armor.confidence > min_confidence_;
 
   // 保存不确定的图案，用于神经网络的迭代
-  // if (name_ok && !confidence_ok) save(armor);
+  if (name_ok && !confidence_ok) save(armor);
 
   return name_ok && confidence_ok;
 }
 
-bool YOLOV5::check_type(const Armor & armor) const
+bool YOLOV5::check_type(const ArmorDetection & armor) const
 {
-  auto name_ok = (armor.type == ArmorType::small)
-                   ? (armor.name != ArmorName::one && armor.name != ArmorName::base)
-                   : (armor.name != ArmorName::two && armor.name != ArmorName::sentry &&
-                      armor.name != ArmorName::outpost);
+  auto name_ok = valid_type(armor.name, armor.type);
 
   // 保存异常的图案，用于神经网络的迭代
-  // if (!name_ok) save(armor);
+  if (!name_ok) save(armor);
 
   return name_ok;
 }
@@ -223,40 +770,10 @@ cv::Point2f YOLOV5::get_center_norm(const cv::Mat & bgr_img, const cv::Point2f &
   return {center.x / w, center.y / h};
 }
 
-void YOLOV5::draw_detections(
-  const cv::Mat & img, const std::list<Armor> & armors, int frame_count) const
-{
-  auto detection = img.clone();
-  tools::draw_text(detection, fmt::format("[{}]", frame_count), {10, 30}, {255, 255, 255});
-  for (const auto & armor : armors) {
-    auto info = fmt::format(
-      "{:.2f} {} {} {}", armor.confidence, COLORS[armor.color], ARMOR_NAMES[armor.name],
-      ARMOR_TYPES[armor.type]);
-    tools::draw_points(detection, armor.points, {0, 255, 0});
-    tools::draw_text(detection, info, armor.center, {0, 255, 0});
-  }
-
-  if (use_roi_) {
-    cv::Scalar green(0, 255, 0);
-    cv::rectangle(detection, roi_, green, 2);
-  }
-  // cv::resize(detection, detection, {}, 0.5, 0.5);  // 显示时缩小图片尺寸
-  // cv::imshow("detection", detection);
-}
-
-void YOLOV5::save(const Armor & armor) const
+void YOLOV5::save(const ArmorDetection & armor) const
 {
-  auto file_name = fmt::format("{:%Y-%m-%d_%H-%M-%S}", std::chrono::system_clock::now());
-  auto img_path = fmt::format("{}/{}_{}.jpg", save_path_, armor.name, file_name);
-  cv::imwrite(img_path, tmp_img_);
-}
-
-double YOLOV5::sigmoid(double x)
-{
-  if (x > 0)
-    return 1.0 / (1.0 + exp(-x));
-  else
-    return exp(x) / (1.0 + exp(x));
+  // 只移交原图的引用计数，编码和写盘在后台完成
+  if (dumper_) dumper_->dump(tmp_img_, ARMOR_NAMES[armor.name]);
 }
 
 }  // namespace auto_aim
\ No newline at end of file
@@ -1,14 +1,25 @@
 #ifndef AUTO_AIM__YOLOV5_HPP
 #define AUTO_AIM__YOLOV5_HPP
 
+#include <chrono>
+#include <deque>
 #include <list>
+#include <memory>
+#include <optional>
 #include <opencv2/opencv.hpp>
 #include <openvino/openvino.hpp>
 #include <string>
 #include <vector>
+#include <yaml-cpp/yaml.h>
 
 #include "tasks/armor.hpp"
+#include "tasks/armor_set.hpp"
 #include "tasks/yolo.hpp"
+#include "tasks/yolos/adaptive_roi.hpp"
+#include "tasks/yolos/corner_refiner.hpp"
+#include "tasks/yolos/yolo_decoder.hpp"
+#include "tools/sample_dumper.hpp"
+#include "tools/worker_pool.hpp"
 
 namespace auto_aim
 {
@@ -17,13 +28,46 @@ class YOLOV5 : public YOLOBase
 public:
   YOLOV5(const std::string & config_path, bool debug);
 
+  ~YOLOV5();
+
   std::list<Armor> detect(const cv::Mat & bgr_img, int frame_count) override;
 
+  const ArmorSet & detect_set(const cv::Mat & bgr_img, int frame_count) override;
+
+  bool detect_async(const cv::Mat & bgr_img, int frame_count) override;
+
+  std::optional<Result> collect() override;
+
+  std::vector<std::list<Armor>> detect_batch(
+    const std::vector<cv::Mat> & imgs, int frame_count) override;
+
+  std::list<Armor> detect_coarse(const cv::Mat & img, int frame_count) override;
+
+  std::vector<std::list<Armor>> detect_regions(
+    const cv::Mat & img, const std::vector<cv::Rect> & rois, int frame_count) override;
+
+  // 各输入尺寸被选中的次数和平均推理延迟
+  struct VariantStats
+  {
+    int input_size;
+    std::size_t picks;
+    double mean_latency_ms;
+  };
+  std::vector<VariantStats> variant_stats() const;
+
+  // 传统方法矫正角点的统计：尝试和成功的装甲板数，成功时关键点的平均修正量
+  struct RefineStats
+  {
+    std::size_t attempts;
+    std::size_t refined;
+    double mean_correction_px;
+  };
+  RefineStats refine_stats() const;
 
 private:
   std::string device_, model_path_;
-  std::string save_path_, debug_path_;
-  bool debug_, use_roi_, use_traditional_;
+  std::string debug_path_;
+  bool debug_, use_roi_, use_traditional_, merge_keypoints_;
 
   const int class_num_ = 13;
   const float nms_threshold_ = 0.3;
@@ -31,24 +75,111 @@ private:
   double min_confidence_, binary_threshold_;
 
   ov::Core core_;
-  ov::CompiledModel compiled_model_;
+  ov::AnyMap compile_config_;  // 性能模式、流数、线程数、精度和核心类型
+
+  // infer request池，每个slot按轮转顺序使用
+  struct InferSlot
+  {
+    ov::InferRequest request;
+    cv::Mat input;         // 直接映射infer request自带的输入张量
+    cv::Size letterbox;    // 上一次缩放后的有效区域，变化时才清零填充带
+    cv::Mat raw_img;       // 提交时的原图
+    cv::Rect roi;          // 本帧在原图上的裁剪区域
+    double scale;
+    int frame_count;
+    std::chrono::steady_clock::time_point start, end;  // 推理开始和完成的时刻
+    ArmorSet armors;       // 本slot最近一帧的识别结果，在slot被再次使用前有效
+  };
+
+  // 同一个模型在某个输入尺寸下的编译结果，构造时一次性创建
+  struct Variant
+  {
+    int input_size;
+    ov::CompiledModel compiled_model;
+    std::vector<InferSlot> slots;
+    std::size_t next_slot = 0;
+    std::size_t in_flight = 0;
+    std::size_t picks = 0;
+    double total_latency_ms = 0;
+  };
+  std::vector<Variant> variants_;  // 按输入尺寸升序排列
+
+  // 在途的帧，按提交顺序排列；空图像不推理，但同样排队，collect时返回空结果
+  struct Pending
+  {
+    static constexpr std::size_t dropped = -1;
+    std::size_t variant, slot;
+    int frame_count;
+  };
+  std::deque<Pending> in_flight_;
+
+  // 批量推理：一次infer处理多张图像或同一张图的多个裁剪区域
+  struct BatchSlot
+  {
+    int batch, input_size;
+    ov::CompiledModel compiled_model;
+    ov::InferRequest request;
+    std::vector<cv::Mat> inputs;         // 每个batch项对应的输入张量切片
+    std::vector<cv::Size> letterboxes;  // 每个batch项上一次缩放后的有效区域
+  };
+  std::unique_ptr<BatchSlot> batch_;   // detect_batch使用，未启用时为空
+  std::unique_ptr<BatchSlot> refine_;  // 级联精检，未启用时为空
+  ArmorSet batch_armors_;              // 批量推理逐项解析时复用
+
+  double min_armor_pixels_;
+  double last_armor_pixels_ = 0;  // 上一帧最小装甲板的像素高度，没有识别结果时为0
+
+  YOLOV5Decoder decoder_;
 
   cv::Rect roi_;
-  cv::Point2f offset_;
-  cv::Mat tmp_img_;
+  std::unique_ptr<AdaptiveROI> adaptive_roi_;  // 未启用时为空
+  cv::Mat tmp_img_;                              // 当前帧原图，保存样本时引用
+  std::unique_ptr<tools::SampleDumper> dumper_;  // 未启用时为空
+
+  std::unique_ptr<CornerRefiner> refiner_;  // use_traditional为false时为空
+  std::unique_ptr<tools::WorkerPool> refine_pool_;
+  std::vector<std::optional<double>> corrections_;  // 本帧每块装甲板的修正量，未矫正为空
+  std::size_t refine_attempts_ = 0, refined_ = 0;
+  double total_correction_px_ = 0;
 
   friend class MultiThreadDetector;
 
-  bool check_name(const Armor & armor) const;
-  bool check_type(const Armor & armor) const;
+  static YOLOV5Decoder::ValidTable make_valid_table(const std::string & enemy_color);
+  static bool valid_type(ArmorName name, ArmorType type);
+  bool check_name(const ArmorDetection & armor) const;
+  bool check_type(const ArmorDetection & armor) const;
+
+  static ov::AnyMap make_compile_config(const YAML::Node & yaml);
+  // 返回选中的模型路径；发生了比对时compiled_model为其按input_size编译的结果
+  std::string select_model(
+    const YAML::Node & yaml, int input_size, int output_top_k,
+    std::optional<ov::CompiledModel> & compiled_model);
+  std::shared_ptr<ov::Model> build_model(
+    std::shared_ptr<ov::Model> model, int batch, int input_size, int output_top_k) const;
+  std::unique_ptr<BatchSlot> make_batch_slot(
+    const std::shared_ptr<ov::Model> & model, int batch, int input_size, int output_top_k);
+
+  cv::Rect select_roi(const cv::Mat & raw_img);
+  std::size_t select_variant(const cv::Rect & roi) const;
+
+  void preprocess(const cv::Mat & raw_img, const cv::Rect & roi, int input_size, InferSlot & slot);
+  double letterbox(const cv::Mat & bgr_img, int input_size, cv::Mat & input, cv::Size & valid_size);
+  const ArmorSet & parse_slot(InferSlot & slot);
+  const ArmorSet & postprocess(Variant & variant, InferSlot & slot);
+
+  std::vector<std::list<Armor>> infer_batch(
+    BatchSlot & slot, const std::vector<cv::Mat> & imgs, const std::vector<cv::Rect> & rois,
+    int frame_count);
 
   cv::Point2f get_center_norm(const cv::Mat & bgr_img, const cv::Point2f & center) const;
 
-  std::list<Armor> parse(double scale, cv::Mat & output, const cv::Mat & bgr_img, int frame_count);
+  void parse(
+    double scale, cv::Mat & output, const cv::Mat & bgr_img, const cv::Rect & roi, int frame_count,
+    ArmorSet & armors);
+
+  void refine_corners(const cv::Mat & bgr_img, ArmorSet & armors);
 
-  void save(const Armor & armor) const;
-  void draw_detections(const cv::Mat & img, const std::list<Armor> & armors, int frame_count) const;
-  double sigmoid(double x);
+  void save(const ArmorDetection & armor) const;
 };
 
 }  // namespace auto_aim
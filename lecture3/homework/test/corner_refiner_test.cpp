@@ -0,0 +1,49 @@
+#include <iostream>
+#include <opencv2/opencv.hpp>
+
+#include "tasks/armor.hpp"
+#include "tasks/yolos/corner_refiner.hpp"
+
+// 与configs/yolo.yaml中的阈值一致
+constexpr double BinaryThreshold = 150;
+constexpr double MaxOffset = 0.5;
+
+// 左右两根竖直灯条，中心分别在x=200和x=400，上下端点在y=150和y=250
+static const cv::Point2f Expected[4] = {{200, 150}, {400, 150}, {400, 250}, {200, 250}};
+static const char * Names[4] = {"top-left", "top-right", "bottom-right", "bottom-left"};
+
+int main()
+{
+  cv::Mat img(480, 640, CV_8UC3, cv::Scalar(0, 0, 0));
+  cv::rectangle(img, cv::Point(195, 150), cv::Point(205, 250), cv::Scalar(255, 255, 255), -1);
+  cv::rectangle(img, cv::Point(395, 150), cv::Point(405, 250), cv::Scalar(255, 255, 255), -1);
+
+  // 神经网络的角点按左上、右上、右下、左下排列，各偏离灯条端点几个像素
+  auto_aim::ArmorDetection armor;
+  armor.points = {
+    cv::Point2f(194, 157), cv::Point2f(407, 144), cv::Point2f(393, 256), cv::Point2f(206, 243)};
+  armor.center = (armor.points[0] + armor.points[1] + armor.points[2] + armor.points[3]) / 4;
+
+  auto_aim::CornerRefiner refiner(BinaryThreshold, MaxOffset);
+  auto correction = refiner.refine(img, armor);
+  if (!correction) {
+    std::cerr << "lightbars were not matched" << std::endl;
+    return 1;
+  }
+
+  // 矫正后的角点贴近灯条端点，且保持左上、右上、右下、左下的顺序
+  for (int i = 0; i < 4; i++) {
+    if (cv::norm(armor.points[i] - Expected[i]) > 2) {
+      std::cerr << Names[i] << " refined to " << armor.points[i] << ", expected " << Expected[i]
+                << std::endl;
+      return 1;
+    }
+  }
+  if (cv::norm(armor.center - cv::Point2f(300, 200)) > 2) {
+    std::cerr << "center refined to " << armor.center << std::endl;
+    return 1;
+  }
+
+  std::cout << "corners refined by " << *correction << " px on average" << std::endl;
+  return 0;
+}
@@ -0,0 +1,112 @@
+#ifndef TOOLS__NMS_HPP
+#define TOOLS__NMS_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+namespace tools
+{
+// 候选框的交并比，Rect可以是cv::Rect或cv::Rect2f
+template <typename Rect>
+float iou(const Rect & a, const Rect & b)
+{
+  auto inter = static_cast<float>((a & b).area());
+  auto uni = static_cast<float>(a.area()) + static_cast<float>(b.area()) - inter;
+  return uni > 0 ? inter / uni : 0.0f;
+}
+
+/**
+ * 在连续存储的候选数组上原地做NMS，结果按置信度降序保留在candidates前部。
+ * Candidate需要有box、confidence和keypoints(std::array<cv::Point2f, N>)成员。
+ * class_of(candidate)返回类别，只有同类之间才会互相抑制；
+ * merge_keypoints为true时，被抑制的重复框按置信度加权合并进保留框的关键点，
+ * 保留框的box随之重建为合并后关键点的外接矩形。
+ * 候选数不超过32时用位掩码记录抑制状态，不产生任何堆分配。
+ */
+template <typename Candidate, typename ClassOf>
+void nms(
+  std::vector<Candidate> & candidates, float iou_threshold, ClassOf class_of,
+  bool merge_keypoints = false)
+{
+  const auto n = candidates.size();
+  if (n == 0) return;
+
+  std::sort(candidates.begin(), candidates.end(), [](const Candidate & a, const Candidate & b) {
+    return a.confidence > b.confidence;
+  });
+
+  std::uint32_t suppressed_mask = 0;
+  static thread_local std::vector<std::uint8_t> suppressed_flags;
+  const bool fast = n <= 32;
+  if (!fast) suppressed_flags.assign(n, 0);
+
+  auto suppressed = [&](std::size_t i) {
+    return fast ? (suppressed_mask >> i) & 1u : suppressed_flags[i] != 0;
+  };
+  auto suppress = [&](std::size_t i) {
+    if (fast)
+      suppressed_mask |= 1u << i;
+    else
+      suppressed_flags[i] = 1;
+  };
+
+  std::size_t kept = 0;
+  for (std::size_t i = 0; i < n; i++) {
+    if (suppressed(i)) continue;
+
+    auto & survivor = candidates[i];
+    auto keypoints = survivor.keypoints;
+    for (auto & point : keypoints) point *= survivor.confidence;
+    auto weight = survivor.confidence;
+
+    for (std::size_t j = i + 1; j < n; j++) {
+      if (suppressed(j)) continue;
+
+      const auto & other = candidates[j];
+      if (class_of(other) != class_of(survivor)) continue;
+      if (iou(survivor.box, other.box) <= iou_threshold) continue;
+
+      suppress(j);
+      if (!merge_keypoints) continue;
+      for (std::size_t k = 0; k < keypoints.size(); k++)
+        keypoints[k] += other.keypoints[k] * other.confidence;
+      weight += other.confidence;
+    }
+
+    if (merge_keypoints && weight > 0) {
+      for (std::size_t k = 0; k < keypoints.size(); k++)
+        survivor.keypoints[k] = keypoints[k] * (1.0f / weight);
+
+      // 关键点移动后框必须一起更新，否则两者不一致
+      auto min_x = survivor.keypoints[0].x, max_x = min_x;
+      auto min_y = survivor.keypoints[0].y, max_y = min_y;
+      for (const auto & point : survivor.keypoints) {
+        min_x = std::min(min_x, point.x);
+        max_x = std::max(max_x, point.x);
+        min_y = std::min(min_y, point.y);
+        max_y = std::max(max_y, point.y);
+      }
+      using Box = decltype(survivor.box);
+      survivor.box = Box(min_x, min_y, max_x - min_x, max_y - min_y);
+    }
+
+    if (kept != i) candidates[kept] = survivor;
+    kept++;
+  }
+
+  candidates.resize(kept);
+}
+
+// 不区分类别的NMS
+template <typename Candidate>
+void nms(std::vector<Candidate> & candidates, float iou_threshold, bool merge_keypoints = false)
+{
+  nms(
+    candidates, iou_threshold, [](const Candidate &) { return 0; }, merge_keypoints);
+}
+
+}  // namespace tools
+
+#endif  // TOOLS__NMS_HPP
@@ -0,0 +1,83 @@
+#include "worker_pool.hpp"
+
+namespace tools
+{
+WorkerPool::WorkerPool(int workers)
+{
+  for (int i = 0; i < workers; i++) threads_.emplace_back(&WorkerPool::work, this);
+}
+
+WorkerPool::~WorkerPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    quit_ = true;
+  }
+  start_cv_.notify_all();
+  for (auto & thread : threads_) thread.join();
+}
+
+void WorkerPool::dispatch(std::size_t n, const Task & task)
+{
+  if (n == 0) return;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    job_ = &task;
+    job_size_ = n;
+    next_ = 0;
+    done_ = 0;
+    generation_++;
+  }
+  start_cv_.notify_all();
+
+  // 调用线程也参与执行，没有工作线程时退化为串行
+  run(task, n);
+
+  // 等待领取了本次任务的工作线程全部退出，避免它们在下一次调用中使用过期的task
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_cv_.wait(lock, [&] { return done_ == n && active_ == 0; });
+  job_ = nullptr;
+}
+
+void WorkerPool::run(const Task & task, std::size_t n)
+{
+  std::size_t count = 0;
+  for (auto i = next_++; i < n; i = next_++) {
+    task(i);
+    count++;
+  }
+  if (count == 0) return;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  done_ += count;
+}
+
+void WorkerPool::work()
+{
+  std::uint64_t seen = 0;
+  while (true) {
+    const Task * job;
+    std::size_t n;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      start_cv_.wait(lock, [&] { return quit_ || (job_ && generation_ != seen); });
+      if (quit_) return;
+
+      seen = generation_;
+      job = job_;
+      n = job_size_;
+      active_++;
+    }
+
+    run(*job, n);
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      active_--;
+    }
+    done_cv_.notify_all();
+  }
+}
+
+}  // namespace tools
@@ -0,0 +1,64 @@
+#ifndef TOOLS__WORKER_POOL_HPP
+#define TOOLS__WORKER_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace tools
+{
+/**
+ * 固定数量的工作线程，按下标把一组小任务分给工作线程和调用线程并行执行。
+ * 任务以不拥有所有权的函数引用传给工作线程，每次调用不产生堆分配；只允许一个线程调用parallel_for。
+ */
+class WorkerPool
+{
+public:
+  explicit WorkerPool(int workers);
+  ~WorkerPool();
+
+  // 并行执行fn(0) ... fn(n - 1)，全部完成后返回；fn只在调用期间被引用，不会被拷贝
+  template <typename Fn>
+  void parallel_for(std::size_t n, Fn && fn)
+  {
+    using F = std::remove_reference_t<Fn>;
+    Task task{const_cast<void *>(static_cast<const void *>(&fn)), [](void * ctx, std::size_t i) {
+                (*static_cast<F *>(ctx))(i);
+              }};
+    dispatch(n, task);
+  }
+
+private:
+  // 类型擦除后的函数引用：上下文指针加调用函数，与std::function不同，不需要存放可调用对象
+  struct Task
+  {
+    void * ctx;
+    void (*invoke)(void *, std::size_t);
+    void operator()(std::size_t i) const { invoke(ctx, i); }
+  };
+
+  std::mutex mutex_;
+  std::condition_variable start_cv_, done_cv_;
+  bool quit_ = false;
+
+  const Task * job_ = nullptr;
+  std::size_t job_size_ = 0;
+  std::uint64_t generation_ = 0;
+  std::atomic<std::size_t> next_{0};
+  std::size_t done_ = 0;
+  int active_ = 0;  // 正在执行当前任务的工作线程数
+
+  std::vector<std::thread> threads_;
+
+  void dispatch(std::size_t n, const Task & task);
+  void run(const Task & task, std::size_t n);
+  void work();
+};
+
+}  // namespace tools
+
+#endif  // TOOLS__WORKER_POOL_HPP
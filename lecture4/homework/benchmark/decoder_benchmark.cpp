@@ -0,0 +1,106 @@
+#include <chrono>
+#include <iostream>
+#include <opencv2/opencv.hpp>
+#include <random>
+#include <vector>
+
+#include "tasks/yolo11_decoder.hpp"
+
+using Candidate = auto_buff::BuffDecoder::Candidate;
+constexpr int NUM_POINTS = auto_buff::BuffLayout::keypoint_num;
+
+// YOLO11_BUFF原先的逐列解码，作为对照
+static int legacy_decode(
+  const cv::Mat & det_output, float factor, float threshold, std::vector<Candidate> & candidates)
+{
+  candidates.clear();
+  for (int i = 0; i < det_output.cols; ++i) {
+    const float score = det_output.at<float>(4, i);
+    if (score > threshold) {
+      const float cx = det_output.at<float>(0, i);
+      const float cy = det_output.at<float>(1, i);
+      const float ow = det_output.at<float>(2, i);
+      const float oh = det_output.at<float>(3, i);
+      Candidate candidate;
+      candidate.box.x = static_cast<int>((cx - 0.5 * ow) * factor);
+      candidate.box.y = static_cast<int>((cy - 0.5 * oh) * factor);
+      candidate.box.width = static_cast<int>(ow * factor);
+      candidate.box.height = static_cast<int>(oh * factor);
+      candidate.confidence = score;
+      candidate.label = 0;
+
+      cv::Mat kpts = det_output.col(i).rowRange(5, 5 + NUM_POINTS * 2);
+      for (int j = 0; j < NUM_POINTS; ++j) {
+        const float x = kpts.at<float>(j * 2 + 0, 0) * factor;
+        const float y = kpts.at<float>(j * 2 + 1, 0) * factor;
+        candidate.keypoints[j] = cv::Point2f(x, y);
+      }
+      candidates.emplace_back(candidate);
+    }
+  }
+  return static_cast<int>(candidates.size());
+}
+
+// get_onecandidatebox原先的逐列最佳anchor查找
+static int legacy_best(const cv::Mat & det_output, float threshold)
+{
+  int best_index = -1;
+  float max_confidence = 0.0f;
+  for (int i = 0; i < det_output.cols; ++i) {
+    const float confidence = det_output.at<float>(4, i);
+    if (confidence > max_confidence) {
+      max_confidence = confidence;
+      best_index = i;
+    }
+  }
+  return max_confidence > threshold ? best_index : -1;
+}
+
+int main(int argc, char ** argv)
+{
+  const int anchors = 8400;
+  const float threshold = 0.7f;
+  const float factor = 2.0f;
+  const int iterations = argc > 1 ? std::stoi(argv[1]) : 500;
+
+  // 模拟真实输出：绝大多数anchor的置信度接近0，少量anchor命中
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<float> coord(0.0f, 640.0f), low(0.0f, 0.3f), high(0.7f, 1.0f);
+  std::bernoulli_distribution hit(0.002);
+  cv::Mat output(auto_buff::BuffLayout::channels, anchors, CV_32F);
+  for (int c = 0; c < output.rows; c++)
+    for (int i = 0; i < anchors; i++) output.at<float>(c, i) = coord(rng);
+  for (int i = 0; i < anchors; i++) output.at<float>(4, i) = hit(rng) ? high(rng) : low(rng);
+
+  auto_buff::BuffDecoder decoder;
+  std::vector<Candidate> legacy_candidates;
+  auto legacy_count = legacy_decode(output, factor, threshold, legacy_candidates);
+  auto decoder_count = static_cast<int>(decoder.decode(output, factor, threshold).size());
+  auto best = decoder.decode_best(output, factor, threshold);
+
+  auto time_us = [&](auto && fn) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) fn();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::micro>(end - start).count() / iterations;
+  };
+
+  volatile int sink = 0;
+  auto legacy_us =
+    time_us([&] { sink = legacy_decode(output, factor, threshold, legacy_candidates); });
+  auto decoder_us = time_us([&] { sink = decoder.decode(output, factor, threshold).size(); });
+  auto legacy_best_us = time_us([&] { sink = legacy_best(output, threshold); });
+  auto decoder_best_us =
+    time_us([&] { sink = decoder.decode_best(output, factor, threshold)->label; });
+
+  std::cout << "anchors: " << anchors << ", candidates: legacy " << legacy_count << " / decoder "
+            << decoder_count << std::endl;
+  std::cout << "legacy decode:      " << legacy_us << " us/frame" << std::endl;
+  std::cout << "BuffDecoder decode: " << decoder_us << " us/frame (x" << legacy_us / decoder_us
+            << ")" << std::endl;
+  std::cout << "legacy best:        " << legacy_best_us << " us/frame" << std::endl;
+  std::cout << "BuffDecoder best:   " << decoder_best_us << " us/frame (x"
+            << legacy_best_us / decoder_best_us << ")" << std::endl;
+
+  return legacy_count == decoder_count && best ? 0 : 1;
+}
@@ -1,9 +1,12 @@
 // 包含必要的头文件
 #include "tasks/buff_detector.hpp" // 自定义的能量机关检测器
+#include "tasks/buff_predictor.hpp" // 击打点预测
 #include "tasks/buff_solver.hpp"   // 自定义的能量机关求解器
+#include "tasks/speed_fitter.hpp"  // 能量机关转速拟合
 #include <chrono>                  // 时间库
 #include <nlohmann/json.hpp>       // JSON库，用于数据序列化
 #include <opencv2/opencv.hpp>      // OpenCV计算机视觉库
+#include "tools/overlay.hpp"       // 调试画面的异步渲染
 #include "tools/plotter.hpp"       // 自定义绘图工具，用于数据可视化
 
 //  相机内参
@@ -14,6 +17,9 @@ static const cv::Mat camera_matrix =
 // 畸变系数
 static const cv::Mat distort_coeffs =
     (cv::Mat_<double>(1, 5) << -0.47562935060124745, 0.21831745829617311, 0.0004957613589406044, -0.00034617769548693592, 0);
+// 弹速(m/s)和从图像时间戳到弹丸出膛的延迟(s)
+static const double BulletSpeed = 24.0;
+static const double SystemDelay = 0.1;
 
 int main()
 {
@@ -30,119 +36,175 @@ int main()
     // 2. 初始化检测器和绘图器
     auto_buff::Buff_Detector detector; // 创建能量机关检测器实例
     auto_buff::Buff_Solver solver;     // 创建能量机关求解器实例
+    auto_buff::SpeedFitter fitter(auto_buff::BIG); // 大符转速拟合，每帧O(1)更新
+    auto_buff::Buff_Predictor predictor(BulletSpeed, SystemDelay); // 击打点预测
     tools::Plotter plotter;            // 创建数据绘图器实例，用于实时数据可视化
+    tools::Overlay overlay(0.8);       // 调试画面的异步渲染，缩放到80%大小
+    overlay.subscribe();               // 本程序显示窗口，因此订阅渲染结果
 
-    // 3. 主循环：逐帧处理视频
-    while (true)
+    // 处理取回的一帧：解算、拟合、预测和绘制，按ESC时返回false
+    auto process = [&](auto_buff::Buff_Detector::Detection detection)
     {
-        cv::Mat img; // 存储当前帧图像
-        cap >> img;  // 从视频中读取一帧
+        auto fanblades = std::move(detection.fanblades);
 
-        // 检查是否成功读取帧（视频结束或读取失败）
-        if (img.empty())
+        // 5. 对每个扇叶进行PnP解算
+        std::vector<auto_buff::Buff_Solver::Solution> solutions(fanblades.size());
+        nlohmann::json data; // 创建JSON对象存储数据
+        for (size_t n = 0; n < fanblades.size(); ++n)
         {
-            std::cout << "视频播放完毕或无法读取帧" << std::endl;
-            break; // 退出循环
+            solver.solvePnP(fanblades[n].points, camera_matrix, distort_coeffs, solutions[n]);
+
+            // 发送数据到plotjuggler
+            if (n == 0 && solutions[n].valid) { // 只记录第一个扇叶的数据
+            data["fan_center_x"] = solutions[n].fan_center.x;
+            data["fan_center_y"] = solutions[n].fan_center.y;
+            data["rotation_center_x"] = solutions[n].rotation_center.x;
+            data["rotation_center_y"] = solutions[n].rotation_center.y;
+            }
         }
 
-        // 4. 使用检测器检测当前帧中的扇叶目标
-        auto fanblades = detector.detect(img);
-
-        // 5. 创建显示图像的副本，用于绘制检测结果
-        cv::Mat display_img = img.clone();
-        nlohmann::json data; // 创建JSON对象存储数据
-    
+        // 用第一个扇叶的角度拟合转速曲线
+        if (!solutions.empty()) fitter.update(solutions[0], detection.timestamp);
+        if (fitter.ready())
+        {
+            auto params = fitter.params();
+            data["fit_speed"] = fitter.speed(0);
+            data["fit_a"] = params.a;
+            data["fit_omega"] = params.omega;
+            data["fit_b"] = params.b;
+            data["fit_rmse"] = fitter.rmse();
+        }
 
-        // 6. 遍历所有检测到的扇叶，在图像上绘制可视化信息
-        int fanblade_count = 0;
-        for (const auto &fanblade : fanblades)
+        // 迭代弹丸飞行时间，得到击打点；多扇叶时待击打扇叶排在最前，未识别出时不瞄准
+        auto_buff::Buff_Predictor::Aim aim;
+        if (!solutions.empty() && (fanblades.size() == 1 || fanblades[0].type == auto_buff::_target))
+            aim = predictor.predict(solutions[0], fitter, detection.timestamp,
+                                      camera_matrix, distort_coeffs);
+        if (aim.valid)
         {
-            cv::Scalar color;      // 根据扇叶类型设置颜色
-            std::string type_name; // 扇叶类型名称
+            data["aim_x"] = aim.point.x;
+            data["aim_y"] = aim.point.y;
+            data["aim_z"] = aim.point.z;
+            data["flight_time"] = aim.flight_time;
+        }
 
-            // 根据扇叶类型设置对应的颜色和名称
-            switch (fanblade.type)
-            {
-            case auto_buff::_target:           // 目标扇叶
-                color = cv::Scalar(0, 255, 0); // 绿色
-                type_name = "_target";
-                break;
-            case auto_buff::_light:              // 亮扇叶
-                color = cv::Scalar(0, 255, 255); // 黄色
-                type_name = "_light";
-                break;
-            case auto_buff::_unlight:          // 未亮扇叶
-                color = cv::Scalar(0, 0, 255); // 红色
-                type_name = "_unlight";
-                break;
-            }
+        // 旋转中心ROI：用本帧的解算结果决定之后提交的帧的裁剪区域
+        detector.update(solutions, detection.img.size());
 
-            // 绘制关键点：在扇叶的各个特征点上画圆并标注序号
-            for (size_t i = 0; i < fanblade.points.size(); ++i)
+        // 6. 绘制交给渲染线程，在缩小后的副本上进行，不影响检测和解算
+        overlay.submit(detection.img, [fanblades, solutions, aim](cv::Mat &canvas, double scale)
+        {
+            for (size_t n = 0; n < fanblades.size(); ++n)
             {
-                cv::circle(display_img, fanblade.points[i], 3, color, -1); // 画实心圆点
-                cv::putText(display_img, std::to_string(i),                // 标注点序号
-                            cv::Point(fanblade.points[i].x + 5, fanblade.points[i].y - 5),
-                            cv::FONT_HERSHEY_SIMPLEX, 0.5, color, 1);
-            }
+                const auto &fanblade = fanblades[n];
+                cv::Scalar color;      // 根据扇叶类型设置颜色
+                std::string type_name; // 扇叶类型名称
+
+                // 根据扇叶类型设置对应的颜色和名称
+                switch (fanblade.type)
+                {
+                case auto_buff::_target:           // 目标扇叶
+                    color = cv::Scalar(0, 255, 0); // 绿色
+                    type_name = "_target";
+                    break;
+                case auto_buff::_light:              // 亮扇叶
+                    color = cv::Scalar(0, 255, 255); // 黄色
+                    type_name = "_light";
+                    break;
+                case auto_buff::_unlight:          // 未亮扇叶
+                    color = cv::Scalar(0, 0, 255); // 红色
+                    type_name = "_unlight";
+                    break;
+                }
 
-            // 绘制中心点：在扇叶中心画圆并标注
-            cv::circle(display_img, fanblade.center, 5, color, -1); // 画中心点
-            cv::putText(display_img, "CENTER",                      // 标注"中心"
-                        cv::Point(fanblade.center.x + 10, fanblade.center.y - 10),
-                        cv::FONT_HERSHEY_SIMPLEX, 0.5, color, 1);
+                // 绘制关键点：在扇叶的各个特征点上画圆并标注序号
+                for (size_t i = 0; i < fanblade.points.size(); ++i)
+                {
+                    cv::Point2f point = fanblade.points[i] * scale;
+                    cv::circle(canvas, point, 3, color, -1); // 画实心圆点
+                    cv::putText(canvas, std::to_string(i),   // 标注点序号
+                                cv::Point(point.x + 5, point.y - 5),
+                                cv::FONT_HERSHEY_SIMPLEX, 0.5, color, 1);
+                }
 
-            // 绘制类型标签：在中心点附近显示扇叶类型
-            cv::putText(display_img, type_name,
-                        cv::Point(fanblade.center.x - 20, fanblade.center.y - 20),
-                        cv::FONT_HERSHEY_SIMPLEX, 0.7, color, 2);
+                // 绘制中心点：在扇叶中心画圆并标注
+                cv::Point2f center = fanblade.center * scale;
+                cv::circle(canvas, center, 5, color, -1); // 画中心点
+                cv::putText(canvas, "CENTER",             // 标注"中心"
+                            cv::Point(center.x + 10, center.y - 10),
+                            cv::FONT_HERSHEY_SIMPLEX, 0.5, color, 1);
 
-            // 进行PnP解算
-            auto_buff::Buff_Solver::Solution solution;
-            solver.solvePnP(fanblade.points, camera_matrix, distort_coeffs, solution);
+                // 绘制类型标签：在中心点附近显示扇叶类型
+                cv::putText(canvas, type_name,
+                            cv::Point(center.x - 20, center.y - 20),
+                            cv::FONT_HERSHEY_SIMPLEX, 0.7, color, 2);
+
+                const auto &solution = solutions[n];
+                if (solution.valid)
+                {
+                    // 绘制解算得到的符中心
+                    cv::Point2f fan_center = solution.fan_center * scale;
+                    cv::circle(canvas, fan_center, 8, cv::Scalar(255, 0, 0), -1);
+                    cv::putText(canvas, "FAN_CENTER",
+                                cv::Point(fan_center.x + 10, fan_center.y - 10),
+                                cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(255, 0, 0), 2);
+
+                    // 绘制解算得到的旋转中心
+                    cv::Point2f rotation_center = solution.rotation_center * scale;
+                    cv::circle(canvas, rotation_center, 8, cv::Scalar(0, 0, 255), -1);
+                    cv::putText(canvas, "ROTATION_CENTER",
+                                cv::Point(rotation_center.x + 10, rotation_center.y - 10),
+                                cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(0, 0, 255), 2);
+
+                    // 绘制从符中心到旋转中心的连线
+                    cv::line(canvas, fan_center, rotation_center, cv::Scalar(255, 255, 0), 2);
+                }
+            }
 
-            if (solution.valid)
+            // 绘制预测的击打点
+            if (aim.valid)
             {
-                // 绘制解算得到的符中心
-                cv::circle(display_img, solution.fan_center, 8, cv::Scalar(255, 0, 0), -1);
-                cv::putText(display_img, "FAN_CENTER",
-                            cv::Point(solution.fan_center.x + 10, solution.fan_center.y - 10),
-                            cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(255, 0, 0), 2);
-
-                // 绘制解算得到的旋转中心
-                cv::circle(display_img, solution.rotation_center, 8, cv::Scalar(0, 0, 255), -1);
-                cv::putText(display_img, "ROTATION_CENTER",
-                            cv::Point(solution.rotation_center.x + 10, solution.rotation_center.y - 10),
-                            cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(0, 0, 255), 2);
-
-                // 绘制从符中心到旋转中心的连线
-                cv::line(display_img, solution.fan_center, solution.rotation_center,
-                         cv::Scalar(255, 255, 0), 2);
-
-                // 发送数据到plotjuggler
-                if(fanblade_count == 0) { // 只记录第一个扇叶的数据
-                data["fan_center_x"] = solution.fan_center.x;
-                data["fan_center_y"] = solution.fan_center.y;
-                data["rotation_center_x"] = solution.rotation_center.x;
-                data["rotation_center_y"] = solution.rotation_center.y;
-                }
+                cv::Point2f pixel = aim.pixel * scale;
+                cv::drawMarker(canvas, pixel, cv::Scalar(255, 0, 255), cv::MARKER_CROSS, 20, 2);
+                cv::putText(canvas, "AIM", cv::Point(pixel.x + 10, pixel.y - 10),
+                            cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(255, 0, 255), 2);
             }
-            
-            fanblade_count++;
-        }
+        });
 
-        // 7. 显示检测结果窗口
-        cv::resize(display_img, display_img, {}, 0.8, 0.8); // 缩放图像到80%大小
-        cv::imshow("Detection Results", display_img);       // 显示处理后的图像
+        // 7. 显示最近一次渲染完成的画面
+        cv::Mat canvas;
+        if (overlay.take(canvas)) cv::imshow("Detection Results", canvas);
         plotter.plot(data);
         
 
-        if (cv::waitKey(30) == 27)
+        return cv::waitKey(30) != 27;
+    };
+
+    // 3. 主循环：逐帧处理视频
+    bool quit = false;
+    while (true)
+    {
+        cv::Mat img; // 存储当前帧图像
+        cap >> img;  // 从视频中读取一帧
+
+        // 检查是否成功读取帧（视频结束或读取失败）
+        if (img.empty())
         {
-            break;
+            std::cout << "视频播放完毕或无法读取帧" << std::endl;
+            break; // 退出循环
         }
+
+        // 4. 提交当前帧，两帧在途时取回较早的一帧，其解算与当前帧的推理重叠；
+        //    两个infer request都在推理时submit返回false，先取回一帧腾出位置
+        while (!quit && !detector.submit(img, std::chrono::steady_clock::now()))
+            quit = !process(*detector.poll());
+        if (!quit && detector.in_flight() == 2) quit = !process(*detector.poll());
+        if (quit) break;
     }
 
+    // 视频结束后取回仍在推理中的帧，最后几帧的结果和曲线不丢失
+    while (!quit && detector.in_flight() > 0) quit = !process(*detector.poll(true));
+
     // 10. 资源清理
     cap.release();           // 释放视频捕获资源
     cv::destroyAllWindows(); // 关闭所有OpenCV窗口
@@ -0,0 +1,106 @@
+#include "blade_tracker.hpp"
+
+#include <cmath>
+
+namespace auto_buff
+{
+constexpr double SLOT_STEP = 2 * M_PI / BladeTracker::SLOT_NUM;
+
+// 折回[-36°, 36°]
+static double wrap_slot(double angle)
+{
+  return angle - std::round(angle / SLOT_STEP) * SLOT_STEP;
+}
+
+BladeTracker::BladeTracker(int max_lost_frames, int confirm_frames)
+: max_lost_frames_(max_lost_frames),
+  confirm_frames_(confirm_frames),
+  slots_{FanBlade(_unlight), FanBlade(_unlight), FanBlade(_unlight), FanBlade(_unlight),
+         FanBlade(_unlight)}
+{
+  reset();
+}
+
+void BladeTracker::reset()
+{
+  tracking_ = false;
+  empty_frames_ = 0;
+  slots_.fill(FanBlade(_unlight));
+  dark_frames_.fill(0);
+  lit_frames_.fill(0);
+}
+
+void BladeTracker::update(std::vector<FanBlade> & fanblades, const cv::Point2f & r_center)
+{
+  // 整个符不在画面中时无法判断哪些扇位熄灭，只在持续足够久后重置
+  if (fanblades.empty()) {
+    if (tracking_ && ++empty_frames_ >= max_lost_frames_) reset();
+    return;
+  }
+  empty_frames_ = 0;
+
+  std::vector<double> angles;
+  for (auto & fanblade : fanblades) {
+    auto offset = fanblade.center - r_center;
+    fanblade.angle = std::atan2(offset.y, offset.x);
+    angles.push_back(fanblade.angle);
+  }
+
+  // 整体相位：所有扇叶相对当前相位的残差取平均，相邻两帧的转角需小于36°
+  if (!tracking_) {
+    phase_ = angles[0];
+    tracking_ = true;
+  }
+  double residual = 0;
+  for (auto angle : angles) residual += wrap_slot(angle - phase_);
+  phase_ = std::remainder(phase_ + residual / angles.size(), 2 * M_PI);
+
+  std::array<const FanBlade *, SLOT_NUM> seen{};
+  for (const auto & fanblade : fanblades) seen[slot_of(fanblade.angle)] = &fanblade;
+
+  // 未点亮的扇位连续出现confirm_frames帧才确认亮起；亮起前已确认熄灭的才是新激活的待击打扇叶，
+  // 跟踪开始时就已亮着的扇位只标为已点亮
+  int new_slot = -1, new_count = 0;
+  for (int i = 0; i < SLOT_NUM; i++) {
+    if (slots_[i].type != _unlight) {
+      if (seen[i]) {
+        auto type = slots_[i].type;
+        slots_[i] = *seen[i];
+        slots_[i].type = type;
+      }
+      continue;
+    }
+    if (!seen[i]) {
+      lit_frames_[i] = 0;
+      dark_frames_[i]++;
+      continue;
+    }
+    if (++lit_frames_[i] < confirm_frames_) continue;
+
+    slots_[i] = *seen[i];
+    slots_[i].type = _light;
+    if (dark_frames_[i] >= confirm_frames_) {
+      new_slot = i;
+      new_count++;
+    }
+  }
+
+  // 只有一个扇位新激活时才能确定待击打扇叶，之前的待击打扇叶已被击中，转为已点亮
+  if (new_count > 0) {
+    for (int i = 0; i < SLOT_NUM; i++)
+      if (slots_[i].type == _target) slots_[i].type = _light;
+    if (new_count == 1) slots_[new_slot].type = _target;
+  }
+
+  // 输出的扇叶类型与扇位一致，尚未确认亮起的扇叶按已点亮输出
+  for (auto & fanblade : fanblades)
+    fanblade.type = slots_[slot_of(fanblade.angle)].type == _target ? _target : _light;
+}
+
+int BladeTracker::slot_of(double angle) const
+{
+  auto slot = static_cast<int>(std::lround((angle - phase_) / SLOT_STEP));
+  return ((slot % SLOT_NUM) + SLOT_NUM) % SLOT_NUM;
+}
+
+}  // namespace auto_buff
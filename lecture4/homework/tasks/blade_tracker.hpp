@@ -0,0 +1,51 @@
+#ifndef AUTO_BUFF__BLADE_TRACKER_HPP
+#define AUTO_BUFF__BLADE_TRACKER_HPP
+
+#include <array>
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+#include "tasks/buff_type.hpp"
+
+namespace auto_buff
+{
+/**
+ * 按相对R标的角度跟踪能量机关的5个扇位，区分待击打和已点亮的扇叶。
+ * 5个扇叶相隔72°，整体旋转的相位由本帧所有扇叶共同估计，扇位编号随符一起转动；
+ * 只有在跟踪中确认过熄灭、随后连续几帧亮起的扇位才是待击打扇叶，击打后保持点亮。
+ * 已点亮的扇位被遮挡或裁出画面后仍保持点亮，重新出现时不会抢占待击打扇叶；
+ * 连续多帧看不到任何扇叶时才视为符被重置。
+ */
+class BladeTracker
+{
+public:
+  static constexpr int SLOT_NUM = 5;
+
+  // 连续max_lost_frames帧没有扇叶时重置，扇位熄灭和亮起都需连续confirm_frames帧确认
+  BladeTracker(int max_lost_frames, int confirm_frames);
+
+  // 用本帧检测到的所有扇叶更新扇位，并把每个扇叶的类型标为_target或_light
+  void update(std::vector<FanBlade> & fanblades, const cv::Point2f & r_center);
+
+  // 各扇位最近的扇叶，未点亮或尚未确认亮起的扇位为FanBlade(_unlight)
+  const std::array<FanBlade, SLOT_NUM> & slots() const { return slots_; }
+
+private:
+  int max_lost_frames_;  // 连续多少帧没有扇叶后视为符被重置
+  int confirm_frames_;
+
+  bool tracking_ = false;
+  double phase_ = 0;  // 0号扇位的角度(rad)，随符旋转
+  int empty_frames_ = 0;
+  std::array<FanBlade, SLOT_NUM> slots_;
+  std::array<int, SLOT_NUM> dark_frames_;  // 未点亮的扇位在跟踪中连续未出现的帧数
+  std::array<int, SLOT_NUM> lit_frames_;   // 未点亮的扇位连续出现的帧数
+
+  void reset();
+
+  int slot_of(double angle) const;
+};
+
+}  // namespace auto_buff
+
+#endif  // AUTO_BUFF__BLADE_TRACKER_HPP
@@ -1,9 +1,29 @@
 #include "buff_detector.hpp"
 
+#include <algorithm>
+
+// 旋转中心ROI：取最近RoiHistory帧的中位数，丢失RoiMaxLostFrames帧后回到全图
+const std::size_t RoiHistory = 30;
+const std::size_t RoiMinSamples = 5;
+const double RoiMargin = 1.3;     // 裁剪边长/旋转直径，覆盖扇叶超出符中心的部分
+const int RoiMinSize = 640;       // 不小于网络输入，裁剪区域按原始分辨率送入
+const int RoiMaxLostFrames = 10;
+
+// 多扇叶模式：连续BladeMaxLostFrames帧没有扇叶时视为符被重置，扇位亮灭需连续BladeConfirmFrames帧确认
+const int BladeMaxLostFrames = 30;
+const int BladeConfirmFrames = 3;
 
 namespace auto_buff
 {
-Buff_Detector::Buff_Detector() : MODE_() {}
+Buff_Detector::Buff_Detector(
+  bool use_rotation_roi, bool multi_blade, const YOLO11_BUFF::Config & model_config)
+: use_rotation_roi_(use_rotation_roi),
+  multi_blade_(multi_blade),
+  rotation_roi_(RoiHistory, RoiMinSamples, RoiMargin, RoiMinSize, RoiMaxLostFrames),
+  tracker_(BladeMaxLostFrames, BladeConfirmFrames),
+  MODE_(model_config)
+{
+}
 
 
 /**
@@ -14,12 +34,72 @@ Buff_Detector::Buff_Detector() : MODE_() {}
  * @param bgr_img 输入图像（BGR格式）
  * @return std::vector<FanBlade> 检测到的扇叶目标列表
  */
-std::vector<FanBlade> Buff_Detector::detect(cv::Mat & bgr_img)
+std::vector<FanBlade> Buff_Detector::detect(const cv::Mat & bgr_img)
 {
     // 1. 使用YOLO模型获取图像中的候选检测框
     // YOLO11_BUFF::Object 包含目标框、关键点等信息
-    std::vector<YOLO11_BUFF::Object> results = MODE_.get_onecandidatebox(bgr_img);
-    
+    auto roi = next_roi(bgr_img);
+    // 多扇叶模式下一次推理得到所有可见扇叶
+    std::vector<YOLO11_BUFF::Object> results = multi_blade_
+      ? MODE_.get_multicandidateboxes(bgr_img(roi))
+      : MODE_.get_onecandidatebox(bgr_img(roi));
+    return to_fanblades(results, roi.tl());
+}
+
+void Buff_Detector::update(
+  const std::vector<Buff_Solver::Solution> & solutions, const cv::Size & img_size)
+{
+    rotation_roi_.update(solutions, img_size);
+}
+
+bool Buff_Detector::submit(
+  const cv::Mat & bgr_img, std::chrono::steady_clock::time_point timestamp)
+{
+    auto roi = next_roi(bgr_img);
+    if (!MODE_.submit(bgr_img(roi), timestamp)) return false;
+    submitted_.emplace_back(bgr_img, roi);
+    return true;
+}
+
+std::optional<Buff_Detector::Detection> Buff_Detector::poll(bool wait)
+{
+    auto result = MODE_.poll(wait, multi_blade_);
+    if (!result) return std::nullopt;
+
+    // 与YOLO11_BUFF的在途帧一一对应，顺序相同
+    auto [img, roi] = submitted_.front();
+    submitted_.pop_front();
+    return Detection{img, result->timestamp, to_fanblades(result->objects, roi.tl())};
+}
+
+cv::Rect Buff_Detector::next_roi(const cv::Mat & bgr_img) const
+{
+    cv::Rect full(0, 0, bgr_img.cols, bgr_img.rows);
+    if (!use_rotation_roi_) return full;
+    // 图像尺寸变化时裁剪区域可能越界，取交集
+    auto roi = rotation_roi_.roi();
+    return roi ? (*roi & full) : full;
+}
+
+std::vector<FanBlade> Buff_Detector::to_fanblades(
+  const std::vector<YOLO11_BUFF::Object> & results, const cv::Point2f & offset)
+{
+    if (multi_blade_) {
+        // 所有扇叶按相对R标的角度归入扇位，区分待击打和已点亮的扇叶
+        std::vector<FanBlade> fanblades;
+        for (auto result : results) {
+            for (auto & point : result.kpt) point += offset;
+            fanblades.emplace_back(FanBlade(result.kpt, result.kpt[4], _light));
+        }
+        tracker_.update(fanblades, fanblades.empty() ? cv::Point2f() : get_r_center(fanblades));
+
+        // 待击打扇叶排在最前
+        std::stable_partition(fanblades.begin(), fanblades.end(), [](const FanBlade & fanblade) {
+            return fanblade.type == _target;
+        });
+        return fanblades;
+    }
+
     // 2. 检查是否有检测结果
     if (results.empty()) {
         // 如果没有检测到任何目标，返回空向量
@@ -31,6 +111,7 @@ std::vector<FanBlade> Buff_Detector::detect(cv::Mat & bgr_img)
     
     // 4. 获取第一个检测结果（通常假设图像中只有一个主要目标）
     auto result = results[0];
+    for (auto & point : result.kpt) point += offset;
     
     // 5. 将YOLO检测结果转换为FanBlade结构
     // 参数说明：
@@ -42,4 +123,14 @@ std::vector<FanBlade> Buff_Detector::detect(cv::Mat & bgr_img)
     // 6. 返回检测到的扇叶列表
     return fanblades;
 }
+
+cv::Point2f Buff_Detector::get_r_center(const std::vector<FanBlade> & fanblades) const
+{
+    // 关键点依次为上、右、下、左和符中心，R标在符中心沿"上->下"方向R_MARK_DISTANCE处
+    constexpr float ratio = Buff_Solver::R_MARK_DISTANCE / (2 * Buff_Solver::FAN_RADIUS);
+    cv::Point2f sum(0, 0);
+    for (const auto & fanblade : fanblades)
+        sum += fanblade.center + (fanblade.points[2] - fanblade.points[0]) * ratio;
+    return sum / static_cast<float>(fanblades.size());
+}
 }  // namespace auto_buff
\ No newline at end of file
@@ -1,7 +1,13 @@
 #ifndef AUTO_BUFF__TRACK_HPP
 #define AUTO_BUFF__TRACK_HPP
 
+#include <chrono>
+#include <deque>
+#include <optional>
+
+#include "blade_tracker.hpp"
 #include "buff_type.hpp"
+#include "rotation_roi.hpp"
 #include "tools/img_tools.hpp"
 #include "yolo11_buff.hpp"
 namespace auto_buff
@@ -9,10 +15,48 @@ namespace auto_buff
 class Buff_Detector
 {
 public:
-  Buff_Detector();
-  std::vector<FanBlade> detect(cv::Mat & bgr_img);
+  // use_rotation_roi: 旋转中心稳定后只在其周围的方形区域内检测
+  // multi_blade: 一次推理检测所有可见扇叶并区分待击打/已点亮，否则只返回置信度最高的一个
+  // model_config: 神经网络的编译和后处理参数
+  explicit Buff_Detector(
+    bool use_rotation_roi = true, bool multi_blade = true,
+    const YOLO11_BUFF::Config & model_config = YOLO11_BUFF::Config());
+  std::vector<FanBlade> detect(const cv::Mat & bgr_img);
+
+  // 用本帧的PnP解算结果更新旋转中心估计，决定之后提交的帧的裁剪区域
+  void update(const std::vector<Buff_Solver::Solution> & solutions, const cv::Size & img_size);
+
+  // 异步检测：提交下一帧后再取回上一帧，使推理与上一帧的PnP和预测重叠
+  struct Detection
+  {
+    cv::Mat img;
+    std::chrono::steady_clock::time_point timestamp;
+    std::vector<FanBlade> fanblades;
+  };
+  bool submit(const cv::Mat & bgr_img, std::chrono::steady_clock::time_point timestamp);
+  std::optional<Detection> poll(bool wait = true);
+  std::size_t in_flight() const { return MODE_.in_flight(); }
+
+  // 多扇叶模式下5个扇位的最新状态，未点亮或尚未确认亮起的扇位为FanBlade(_unlight)
+  const std::array<FanBlade, BladeTracker::SLOT_NUM> & blade_slots() const
+  {
+    return tracker_.slots();
+  }
+
 private:
-  cv::Point2f get_r_center(std::vector<FanBlade> & fanblades, cv::Mat & bgr_img);
+  // offset为裁剪区域左上角，检测结果平移回原图坐标
+  std::vector<FanBlade> to_fanblades(
+    const std::vector<YOLO11_BUFF::Object> & results, const cv::Point2f & offset);
+
+  cv::Rect next_roi(const cv::Mat & bgr_img) const;
+
+  bool use_rotation_roi_;
+  bool multi_blade_;
+  RotationROI rotation_roi_;
+  BladeTracker tracker_;
+  std::deque<std::pair<cv::Mat, cv::Rect>> submitted_;  // 在途帧的原图和裁剪区域
+  // 由各扇叶关键点的几何关系估计R标的图像坐标
+  cv::Point2f get_r_center(const std::vector<FanBlade> & fanblades) const;
   YOLO11_BUFF MODE_;
 };
 }  // namespace auto_buff
@@ -0,0 +1,59 @@
+#include "buff_predictor.hpp"
+
+const int FlightTimeIterations = 3;  // 飞行时间迭代次数，通常两次即收敛到毫秒以内
+
+namespace auto_buff
+{
+Buff_Predictor::Buff_Predictor(double bullet_speed, double system_delay)
+: bullet_speed_(bullet_speed), system_delay_(system_delay)
+{
+}
+
+Buff_Predictor::Aim Buff_Predictor::predict(
+  const Buff_Solver::Solution & solution, const SpeedFitter & fitter,
+  std::chrono::steady_clock::time_point timestamp, const cv::Mat & camera_matrix,
+  const cv::Mat & dist_coeffs) const
+{
+  Aim aim;
+  if (!solution.valid || !fitter.ready()) return aim;
+
+  // 相机坐标系下的转轴：符平面法向，经过R标
+  cv::Matx33d R;
+  cv::Rodrigues(solution.rvec, R);
+  const cv::Vec3d tvec = solution.tvec;
+  const cv::Vec3d center = R * cv::Vec3d(0, -Buff_Solver::R_MARK_DISTANCE, 0) + tvec;
+  const cv::Vec3d radius = tvec - center;  // R标指向符中心
+  cv::Vec3d axis = R * cv::Vec3d(0, 0, 1);
+
+  // 图像y轴向下，绕指向场景的轴正转时图像角度增大，与拟合器的角度方向一致
+  if (axis[2] < 0) axis = -axis;
+
+  // Rodrigues公式，radius与axis垂直
+  auto rotate = [&](double angle) {
+    return center + radius * std::cos(angle) + axis.cross(radius) * std::sin(angle);
+  };
+
+  // 飞行时间与转角交替迭代，次数固定
+  cv::Vec3d point = tvec;
+  double flight_time = 0;
+  for (int i = 0; i < FlightTimeIterations; i++) {
+    flight_time = cv::norm(point) / 1000.0 / bullet_speed_;
+    point = rotate(*fitter.predict(system_delay_ + flight_time));
+  }
+
+  std::vector<cv::Point2f> pixels;
+  cv::projectPoints(
+    std::vector<cv::Point3d>{cv::Point3d(point)}, cv::Vec3d(0, 0, 0), cv::Vec3d(0, 0, 0),
+    camera_matrix, dist_coeffs, pixels);
+
+  aim.point = cv::Point3f(point[0] / 1000.0, point[1] / 1000.0, point[2] / 1000.0);
+  aim.pixel = pixels[0];
+  aim.flight_time = flight_time;
+  aim.fire_time =
+    timestamp + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                  std::chrono::duration<double>(system_delay_));
+  aim.valid = true;
+  return aim;
+}
+
+}  // namespace auto_buff
@@ -0,0 +1,44 @@
+#ifndef AUTO_BUFF__PREDICTOR_HPP
+#define AUTO_BUFF__PREDICTOR_HPP
+
+#include <chrono>
+#include <opencv2/opencv.hpp>
+
+#include "tasks/buff_solver.hpp"
+#include "tasks/speed_fitter.hpp"
+
+namespace auto_buff
+{
+/**
+ * 击打点预测：符中心绕R标所在的转轴转过拟合得到的角度，弹丸飞行时间与预测角度交替迭代固定次数，
+ * 每帧耗时确定。弹丸按匀速直线飞行估计时间，重力补偿交给云台解算。
+ */
+class Buff_Predictor
+{
+public:
+  struct Aim
+  {
+    cv::Point3f point;   // 击打点，相机坐标系(m)
+    cv::Point2f pixel;   // 击打点在当前帧图像上的投影
+    double flight_time;  // 弹丸飞行时间(s)
+    std::chrono::steady_clock::time_point fire_time;  // 按该击打点瞄准后的开火时刻
+    bool valid = false;
+  };
+
+  // bullet_speed: 弹速(m/s)，system_delay: 从图像时间戳到弹丸出膛的延迟(s)
+  Buff_Predictor(double bullet_speed, double system_delay);
+
+  // solution与fitter最近一次观测须来自同一帧，timestamp为该帧时间戳
+  Aim predict(
+    const Buff_Solver::Solution & solution, const SpeedFitter & fitter,
+    std::chrono::steady_clock::time_point timestamp, const cv::Mat & camera_matrix,
+    const cv::Mat & dist_coeffs) const;
+
+private:
+  double bullet_speed_;
+  double system_delay_;
+};
+
+}  // namespace auto_buff
+
+#endif  // AUTO_BUFF__PREDICTOR_HPP
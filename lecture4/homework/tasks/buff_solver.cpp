@@ -65,6 +65,8 @@ namespace auto_buff
         cv::projectPoints(points3d, rvec, tvec, camera_matrix, dist_coeffs, points2d);
         solution.fan_center = points2d[0];      // 获取符中心在图像上的投影坐标
         solution.rotation_center = points2d[1]; // 获取旋转中心在图像上的投影坐标
+        solution.rvec = rvec;                   // 保存位姿，供击打点预测使用
+        solution.tvec = tvec;
 
         // 输出调试信息
         std::cout << "PnP solve successful - Fan Center: " << solution.fan_center << ", Rotation Center: " << solution.rotation_center << std::endl;
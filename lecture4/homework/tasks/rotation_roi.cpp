@@ -0,0 +1,69 @@
+#include "rotation_roi.hpp"
+
+#include <algorithm>
+
+namespace auto_buff
+{
+// 逐分量取中位数，单帧PnP的离群值不会拉偏估计
+template <typename T, typename Get>
+static float median(const std::deque<T> & values, Get get)
+{
+  std::vector<float> sorted;
+  sorted.reserve(values.size());
+  for (const auto & value : values) sorted.push_back(get(value));
+  std::nth_element(sorted.begin(), sorted.begin() + sorted.size() / 2, sorted.end());
+  return sorted[sorted.size() / 2];
+}
+
+RotationROI::RotationROI(
+  std::size_t history, std::size_t min_samples, double margin, int min_size, int max_lost_frames)
+: history_(history),
+  min_samples_(min_samples),
+  margin_(margin),
+  min_size_(min_size),
+  max_lost_frames_(max_lost_frames)
+{
+}
+
+void RotationROI::update(
+  const std::vector<Buff_Solver::Solution> & solutions, const cv::Size & img_size)
+{
+  auto valid = std::find_if(
+    solutions.begin(), solutions.end(), [](const auto & solution) { return solution.valid; });
+  if (valid == solutions.end()) {
+    if (++lost_frames_ > max_lost_frames_) {
+      centers_.clear();
+      radii_.clear();
+    }
+    return;
+  }
+  lost_frames_ = 0;
+
+  centers_.push_back(valid->rotation_center);
+  radii_.push_back(static_cast<float>(cv::norm(valid->fan_center - valid->rotation_center)));
+  if (centers_.size() > history_) {
+    centers_.pop_front();
+    radii_.pop_front();
+  }
+  if (centers_.size() < min_samples_) return;
+
+  cv::Point2f center(
+    median(centers_, [](const cv::Point2f & p) { return p.x; }),
+    median(centers_, [](const cv::Point2f & p) { return p.y; }));
+  auto radius = median(radii_, [](float r) { return r; });
+
+  auto side = static_cast<int>(std::max<double>(2 * radius * margin_, min_size_));
+  auto width = std::min(side, img_size.width);
+  auto height = std::min(side, img_size.height);
+  auto x = std::clamp(static_cast<int>(center.x) - width / 2, 0, img_size.width - width);
+  auto y = std::clamp(static_cast<int>(center.y) - height / 2, 0, img_size.height - height);
+  roi_ = cv::Rect(x, y, width, height);
+}
+
+std::optional<cv::Rect> RotationROI::roi() const
+{
+  if (centers_.size() < min_samples_) return std::nullopt;
+  return roi_;
+}
+
+}  // namespace auto_buff
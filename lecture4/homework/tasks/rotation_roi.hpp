@@ -0,0 +1,42 @@
+#ifndef AUTO_BUFF__ROTATION_ROI_HPP
+#define AUTO_BUFF__ROTATION_ROI_HPP
+
+#include <deque>
+#include <opencv2/opencv.hpp>
+#include <optional>
+#include <vector>
+
+#include "tasks/buff_solver.hpp"
+
+namespace auto_buff
+{
+// 能量机关绕R标旋转，目标始终在以旋转中心为圆心的圆盘内，按原始分辨率裁剪该圆盘送入网络
+class RotationROI
+{
+public:
+  RotationROI(
+    std::size_t history, std::size_t min_samples, double margin, int min_size,
+    int max_lost_frames);
+
+  // 用一帧的解算结果更新旋转中心估计，img_size为原图尺寸
+  void update(const std::vector<Buff_Solver::Solution> & solutions, const cv::Size & img_size);
+
+  // 下一帧的裁剪区域，样本不足或连续max_lost_frames帧未识别后返回空，即使用全图
+  std::optional<cv::Rect> roi() const;
+
+private:
+  std::size_t history_;      // 参与估计的最近样本数
+  std::size_t min_samples_;  // 开始裁剪所需的样本数
+  double margin_;            // 裁剪边长相对扇叶旋转直径的倍数
+  int min_size_;             // 裁剪最小边长(像素)，不小于网络输入时不会缩小画面
+  int max_lost_frames_;      // 连续丢失多少帧后回到全图
+
+  int lost_frames_ = 0;
+  std::deque<cv::Point2f> centers_;  // 最近的旋转中心
+  std::deque<float> radii_;          // 最近的符中心到旋转中心的距离
+  cv::Rect roi_;
+};
+
+}  // namespace auto_buff
+
+#endif  // AUTO_BUFF__ROTATION_ROI_HPP
@@ -0,0 +1,278 @@
+#include "speed_fitter.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+const std::size_t WindowSize = 512;       // 滑动窗口样本数，约5s
+const double ForgettingFactor = 0.998;    // 递推最小二乘的遗忘因子
+const std::size_t MinSamples = 15;        // 开始预测所需的样本数
+const double MinSpan = 0.3;               // 开始预测所需的时间跨度(s)
+const double MaxGap = 0.3;                // 两帧间隔超过该值时无法判断扇叶切换，重新开始(s)
+const std::size_t RefitInterval = 30;     // 每隔多少帧请求一次后台重拟合
+const double RefitMinSpan = 0.5;          // 后台重拟合ω所需的最短时间跨度(s)
+const double OmegaMin = 1.884, OmegaMax = 2.000;  // 规则给定的大符ω范围
+const int OmegaGrid = 13;
+const int GaussNewtonIterations = 10;
+
+namespace auto_buff
+{
+SpeedFitter::SpeedFitter(PowerRune_type type)
+: type_(type), window_(WindowSize), worker_(&SpeedFitter::work, this)
+{
+  reset();
+}
+
+SpeedFitter::~SpeedFitter()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    quit_ = true;
+  }
+  cv_.notify_all();
+  worker_.join();
+}
+
+void SpeedFitter::reset()
+{
+  started_ = false;
+  head_ = size_ = samples_ = 0;
+  frames_since_refit_ = 0;
+  omega_ = (OmegaMin + OmegaMax) / 2;
+  x_.setZero();
+  P_.setZero();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  generation_++;
+  pending_.reset();
+  result_.reset();
+}
+
+void SpeedFitter::update(double angle, std::chrono::steady_clock::time_point timestamp)
+{
+  if (started_ && std::chrono::duration<double>(timestamp - last_time_).count() > MaxGap) reset();
+
+  if (!started_) {
+    started_ = true;
+    t0_ = timestamp;
+    last_raw_ = last_angle_ = angle;
+    // θ0由第一帧确定，其余参数没有先验
+    x_ << angle, 0, 0, 0;
+    P_ = covariance({1e-2, 1e2, 1e2, 1e2});
+  } else {
+    // 扇叶之间相差72°，把相邻两帧的角度差折回[-36°, 36°]，同时处理了±π跳变
+    constexpr double blade_step = 2 * M_PI / 5;
+    auto delta = angle - last_raw_;
+    delta -= std::round(delta / blade_step) * blade_step;
+    last_raw_ = angle;
+    last_angle_ += delta;
+  }
+  last_time_ = timestamp;
+  last_t_ = std::chrono::duration<double>(timestamp - t0_).count();
+
+  // 取回后台重拟合的结果，替换ω并以批量解重新初始化递推
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (result_ && result_->generation == generation_) {
+      x_ = result_->x;
+      omega_ = result_->omega;
+      P_ = covariance({1e-4, 1e-2, 1e-2, 1e-2});
+    }
+    result_.reset();
+  }
+
+  // 递推最小二乘，遗忘因子使旧样本的权重指数衰减
+  const Eigen::Vector4d phi = regressor(last_t_, omega_);
+  const Eigen::Vector4d k = P_ * phi / (ForgettingFactor + phi.dot(P_ * phi));
+  x_ += k * (last_angle_ - phi.dot(x_));
+  P_ = (P_ - k * phi.transpose() * P_) / ForgettingFactor;
+
+  push({last_t_, last_angle_});
+  samples_++;
+  if (type_ == BIG && ++frames_since_refit_ >= RefitInterval) {
+    frames_since_refit_ = 0;
+    request_refit();
+  }
+}
+
+void SpeedFitter::update(
+  const Buff_Solver::Solution & solution, std::chrono::steady_clock::time_point timestamp)
+{
+  if (!solution.valid) return;
+  const auto offset = solution.fan_center - solution.rotation_center;
+  update(std::atan2(offset.y, offset.x), timestamp);
+}
+
+bool SpeedFitter::ready() const
+{
+  if (!started_ || size_ < MinSamples) return false;
+  return last_t_ - window_[head_].t >= MinSpan;
+}
+
+std::optional<double> SpeedFitter::predict(double dt) const
+{
+  if (!ready()) return std::nullopt;
+  return model(x_, omega_, last_t_ + dt) - model(x_, omega_, last_t_);
+}
+
+double SpeedFitter::speed(double dt) const
+{
+  const auto t = last_t_ + dt;
+  return x_[1] + x_[2] * std::sin(omega_ * t) + x_[3] * std::cos(omega_ * t);
+}
+
+SpeedFitter::Params SpeedFitter::params() const
+{
+  return {std::hypot(x_[2], x_[3]), omega_, std::atan2(x_[3], x_[2]), x_[1]};
+}
+
+double SpeedFitter::rmse() const
+{
+  if (size_ == 0) return 0;
+  double sum = 0;
+  for (std::size_t i = 0; i < size_; i++) {
+    const auto & sample = window_[(head_ + i) % WindowSize];
+    const auto error = sample.angle - model(x_, omega_, sample.t);
+    sum += error * error;
+  }
+  return std::sqrt(sum / size_);
+}
+
+Eigen::Vector4d SpeedFitter::regressor(double t, double omega) const
+{
+  // 小符只有θ0和b两个参数
+  if (type_ == SMALL) return {1, t, 0, 0};
+  return {1, t, -std::cos(omega * t) / omega, std::sin(omega * t) / omega};
+}
+
+Eigen::Matrix4d SpeedFitter::covariance(const Eigen::Vector4d & variance) const
+{
+  // 小符的A、B不在回归量中，没有观测约束它们，其方差每帧除以遗忘因子会无限增长直至溢出，
+  // 因此置零，递推只在[θ0, b]上进行
+  Eigen::Vector4d diagonal = variance;
+  if (type_ == SMALL) diagonal.tail<2>().setZero();
+  return diagonal.asDiagonal();
+}
+
+double SpeedFitter::model(const Eigen::Vector4d & x, double omega, double t) const
+{
+  return regressor(t, omega).dot(x);
+}
+
+void SpeedFitter::push(const Sample & sample)
+{
+  if (size_ < WindowSize) {
+    window_[(head_ + size_++) % WindowSize] = sample;
+  } else {
+    window_[head_] = sample;
+    head_ = (head_ + 1) % WindowSize;
+  }
+}
+
+void SpeedFitter::request_refit()
+{
+  if (size_ < MinSamples || last_t_ - window_[head_].t < RefitMinSpan) return;
+
+  // 只在工作线程空闲时拷贝窗口，拷贝开销按RefitInterval摊薄
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (pending_) return;
+  Refit refit{{}, generation_};
+  refit.samples.reserve(size_);
+  for (std::size_t i = 0; i < size_; i++)
+    refit.samples.push_back(window_[(head_ + i) % WindowSize]);
+  pending_ = std::move(refit);
+  cv_.notify_one();
+}
+
+void SpeedFitter::work()
+{
+  while (true) {
+    Refit job;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this] { return quit_ || pending_; });
+      if (quit_) return;
+      job = std::move(*pending_);
+    }
+
+    Eigen::Vector4d x;
+    double omega;
+    auto ok = refit(job.samples, x, omega);
+
+    // pending_在计算完成后才清空，计算期间主线程不会再拷贝窗口
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_.reset();
+    if (ok && job.generation == generation_) result_ = RefitResult{x, omega, job.generation};
+  }
+}
+
+bool SpeedFitter::refit(const std::vector<Sample> & samples, Eigen::Vector4d & x, double & omega)
+  const
+{
+  // ω固定时的线性最小二乘，返回残差平方和
+  auto solve = [&](double w, Eigen::Vector4d & solution) {
+    Eigen::Matrix4d A = Eigen::Matrix4d::Zero();
+    Eigen::Vector4d rhs = Eigen::Vector4d::Zero();
+    for (const auto & sample : samples) {
+      const Eigen::Vector4d phi = regressor(sample.t, w);
+      A += phi * phi.transpose();
+      rhs += phi * sample.angle;
+    }
+    solution = A.ldlt().solve(rhs);
+    double cost = 0;
+    for (const auto & sample : samples) {
+      const auto error = sample.angle - regressor(sample.t, w).dot(solution);
+      cost += error * error;
+    }
+    return cost;
+  };
+
+  // 先在规则范围内网格搜索ω，避免Gauss-Newton落入局部极小
+  double best_cost = INFINITY;
+  for (int i = 0; i < OmegaGrid; i++) {
+    const auto w = OmegaMin + (OmegaMax - OmegaMin) * i / (OmegaGrid - 1);
+    Eigen::Vector4d solution;
+    const auto cost = solve(w, solution);
+    if (cost < best_cost) {
+      best_cost = cost;
+      x = solution;
+      omega = w;
+    }
+  }
+  if (!std::isfinite(best_cost)) return false;
+
+  // 对[θ0, b, A, B, ω]联合做Gauss-Newton
+  Eigen::Matrix<double, 5, 1> p;
+  p << x, omega;
+  for (int iter = 0; iter < GaussNewtonIterations; iter++) {
+    Eigen::Matrix<double, 5, 5> H = Eigen::Matrix<double, 5, 5>::Zero();
+    Eigen::Matrix<double, 5, 1> g = Eigen::Matrix<double, 5, 1>::Zero();
+    const double w = p[4];
+    for (const auto & sample : samples) {
+      const auto t = sample.t;
+      const auto c = std::cos(w * t), s = std::sin(w * t);
+      Eigen::Matrix<double, 5, 1> J;
+      J << 1, t, -c / w, s / w,
+        p[2] * (t * s / w + c / (w * w)) + p[3] * (t * c / w - s / (w * w));
+      const auto error = sample.angle - (p[0] + p[1] * t - p[2] * c / w + p[3] * s / w);
+      H += J * J.transpose();
+      g += J * error;
+    }
+    const Eigen::Matrix<double, 5, 1> step = H.ldlt().solve(g);
+    if (!step.allFinite()) break;
+    p += step;
+    p[4] = std::clamp(p[4], OmegaMin, OmegaMax);
+    if (step.norm() < 1e-8) break;
+  }
+
+  if (!p.allFinite()) return true;  // 保留网格搜索的结果
+
+  // 在Gauss-Newton得到的ω下重解线性参数，残差不变差时才采用
+  Eigen::Vector4d check;
+  if (solve(p[4], check) <= best_cost) {
+    x = check;
+    omega = p[4];
+  }
+  return true;
+}
+
+}  // namespace auto_buff
@@ -0,0 +1,119 @@
+#ifndef AUTO_BUFF__SPEED_FITTER_HPP
+#define AUTO_BUFF__SPEED_FITTER_HPP
+
+#include <eigen3/Eigen/Dense>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "tasks/buff_solver.hpp"
+#include "tasks/buff_type.hpp"
+
+namespace auto_buff
+{
+/**
+ * 能量机关转速拟合。大符转速为spd = a·sin(ω·t+φ) + b，小符为常数b。
+ * 对转速积分后，角度在ω固定时对参数x = [θ0, b, A, B]线性：
+ *   θ(t) = θ0 + b·t - A·cos(ω·t)/ω + B·sin(ω·t)/ω，其中A = a·cos(φ)，B = a·sin(φ)
+ * 每帧用带遗忘因子的递推最小二乘更新x，耗时O(1)，激活后一秒内即可预测；
+ * ω的估计由后台线程在滑动窗口上做网格搜索+Gauss-Newton批量重拟合，主循环只在update中取回结果。
+ */
+class SpeedFitter
+{
+public:
+  struct Params
+  {
+    double a, omega, phi, b;
+  };
+
+  explicit SpeedFitter(PowerRune_type type);
+  ~SpeedFitter();
+
+  // 输入一帧的扇叶角度(rad，图像坐标系)和时间戳，自动处理±π跳变和扇叶切换的72°跳变
+  void update(double angle, std::chrono::steady_clock::time_point timestamp);
+
+  // 用PnP解算得到的符中心和旋转中心计算扇叶角度，无效解算直接忽略
+  void update(
+    const Buff_Solver::Solution & solution, std::chrono::steady_clock::time_point timestamp);
+
+  // 丢弃所有样本和拟合结果，切换大小符时使用
+  void reset();
+
+  // 样本数和时间跨度都足够时为true
+  bool ready() const;
+
+  // 从最近一次观测起再转过dt秒的角度(rad)，未就绪时返回空
+  std::optional<double> predict(double dt) const;
+
+  // t时刻(相对最近一次观测，s)的转速(rad/s)
+  double speed(double dt) const;
+
+  Params params() const;
+
+  // 窗口内角度残差的均方根(rad)
+  double rmse() const;
+
+private:
+  struct Sample
+  {
+    double t;      // 相对第一次观测的时间(s)
+    double angle;  // 展开后的角度(rad)
+  };
+
+  PowerRune_type type_;
+
+  // 递推最小二乘
+  Eigen::Vector4d x_;
+  Eigen::Matrix4d P_;
+  double omega_;
+
+  // 滑动窗口，定长环形缓冲区
+  std::vector<Sample> window_;
+  std::size_t head_ = 0, size_ = 0;
+
+  bool started_ = false;
+  std::chrono::steady_clock::time_point t0_, last_time_;
+  double last_raw_ = 0, last_angle_ = 0, last_t_ = 0;
+  std::size_t frames_since_refit_ = 0;
+  std::size_t samples_ = 0;
+
+  // 后台批量重拟合
+  struct Refit
+  {
+    std::vector<Sample> samples;
+    std::uint64_t generation;
+  };
+  struct RefitResult
+  {
+    Eigen::Vector4d x;
+    double omega;
+    std::uint64_t generation;
+  };
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool quit_ = false;
+  std::optional<Refit> pending_;
+  std::optional<RefitResult> result_;
+  std::uint64_t generation_ = 0;  // reset后丢弃旧窗口的重拟合结果
+  std::thread worker_;
+
+  Eigen::Vector4d regressor(double t, double omega) const;
+  // 以variance为对角线的初始协方差，小符只保留[θ0, b]
+  Eigen::Matrix4d covariance(const Eigen::Vector4d & variance) const;
+  double model(const Eigen::Vector4d & x, double omega, double t) const;
+
+  void push(const Sample & sample);
+  void request_refit();
+  void work();
+
+  // 在samples上重拟合[x, ω]，返回false表示样本不足或不收敛
+  bool refit(const std::vector<Sample> & samples, Eigen::Vector4d & x, double & omega) const;
+};
+
+}  // namespace auto_buff
+
+#endif  // AUTO_BUFF__SPEED_FITTER_HPP
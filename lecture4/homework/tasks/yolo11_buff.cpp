@@ -1,228 +1,253 @@
 #include "yolo11_buff.hpp"
 
+#include <openvino/opsets/opset8.hpp>
+
+#include <chrono>
+#include <optional>
+
+#include "tools/logger.hpp"
+#include "tools/nms.hpp"
+
 const double ConfidenceThreshold = 0.7f;
 const double IouThreshold = 0.4f;
+const int InputSize = 640;
+
+const std::string ModelPath = "assets/yolo11_buff_int8.xml";
+
+// 后台保存低置信度的识别结果，Config::sample_dump开启时生效
+const double UncertainConfidence = 0.8;    // 高于ConfidenceThreshold但低于该值时保存
+const std::string DumpDir = "../result/";
+const std::size_t DumpQueueSize = 8;       // 待保存队列长度，满时丢弃
+const int DumpWorkers = 1;                 // JPEG编码线程数
+const double DumpInterval = 1.0;           // 两次保存的最小间隔(s)
+const std::size_t DumpQuotaMB = 1024;      // 保存目录的磁盘配额(MB)
 namespace auto_buff
 {
-YOLO11_BUFF::YOLO11_BUFF()
+ov::Output<ov::Node> select_candidates(
+  const ov::Output<ov::Node> & output, float threshold, int top_k)
 {
-  model = core.read_model("assets/yolo11_buff_int8.xml");
-  compiled_model = core.compile_model(model, "CPU");
-  infer_request = compiled_model.create_infer_request();
-  input_tensor = infer_request.get_input_tensor();
-  input_tensor.set_shape({1, 3, 640, 640});
+  using namespace ov::opset8;
+  auto i64 = [](const std::vector<int64_t> & values) {
+    return Constant::create(ov::element::i64, ov::Shape{values.size()}, values);
+  };
+  auto f32 = [](float value) { return Constant::create(ov::element::f32, ov::Shape{}, {value}); };
+
+  constexpr int64_t score_row = BuffLayout::class_row;
+  auto score = std::make_shared<Squeeze>(
+    std::make_shared<Slice>(output, i64({score_row}), i64({score_row + 1}), i64({1}), i64({1})),
+    i64({1}));
+  auto masked = std::make_shared<Select>(
+    std::make_shared<Greater>(score, f32(threshold)), score, f32(0.0f));
+  auto selected = std::make_shared<TopK>(
+    masked, Constant::create(ov::element::i64, ov::Shape{}, {top_k}), 1, "max", "value");
+  auto axis = Constant::create(ov::element::i64, ov::Shape{}, {2});
+  return std::make_shared<Gather>(output, selected->output(1), axis, 1)->output(0);
 }
 
-std::vector<YOLO11_BUFF::Object> YOLO11_BUFF::get_multicandidateboxes(cv::Mat & image)
+YOLO11_BUFF::YOLO11_BUFF() : YOLO11_BUFF(Config()) {}
+
+YOLO11_BUFF::YOLO11_BUFF(const Config & config) : config_(config)
 {
-  const int64 start = cv::getTickCount();  
+  if (config_.candidate_top_k <= 0)
+    throw std::runtime_error("[YOLO11_BUFF] candidate_top_k must be positive");
 
-  if (image.empty()) {
-    return std::vector<YOLO11_BUFF::Object> ();
+  if (config_.sample_dump) {
+    dumper_ = std::make_unique<tools::SampleDumper>(
+      DumpDir, DumpQueueSize, DumpWorkers, DumpInterval, DumpQuotaMB);
   }
 
-  cv::Mat bgr_img = image;
+  // 编译缓存和mmap加载权重，缩短崩溃重启后的启动时间
+  if (!config_.cache_dir.empty()) core.set_property(ov::cache_dir(config_.cache_dir));
+  core.set_property(ov::enable_mmap(true));
 
-  auto x_scale = static_cast<double>(640) / bgr_img.rows;
-  auto y_scale = static_cast<double>(640) / bgr_img.cols;
-  auto scale = std::min(x_scale, y_scale);
-  auto h = static_cast<int>(bgr_img.rows * scale);
-  auto w = static_cast<int>(bgr_img.cols * scale);
+  auto ms_since = [](std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+      .count();
+  };
+
+  auto read_start = std::chrono::steady_clock::now();
+  auto network = core.read_model(ModelPath);
+  auto read_ms = ms_since(read_start);
 
-  double factor = scale;  
+  auto compile_start = std::chrono::steady_clock::now();
+  compiled_model = compile(network);
+  auto compile_ms = ms_since(compile_start);
 
-  auto input = cv::Mat(640, 640, CV_8UC3, cv::Scalar(0, 0, 0));
-  auto roi = cv::Rect(0, 0, w, h);
-  cv::resize(bgr_img, input(roi), {w, h});
-  ov::Tensor input_tensor(ov::element::u8, {1, 640, 640, 3}, input.data);
+  for (auto & slot : slots_) {
+    slot.request = compiled_model.create_infer_request();
+    slot.input = cv::Mat(InputSize, InputSize, CV_8UC3, cv::Scalar::all(0));
+    slot.request.set_input_tensor(
+      ov::Tensor(ov::element::u8, {1, InputSize, InputSize, 3}, slot.input.data));
+  }
 
+  // 预热：首次推理的延迟初始化放在构造函数里完成
+  auto warmup_start = std::chrono::steady_clock::now();
+  for (int i = 0; i < config_.warmup_iterations; i++)
+    for (auto & slot : slots_) slot.request.infer();
+  auto warmup_ms = ms_since(warmup_start);
 
-  infer_request.infer();
+  tools::logger()->info(
+    "[YOLO11_BUFF] {}: read {:.1f} ms, compile {:.1f} ms, warm-up {:.1f} ms ({} iterations)",
+    ModelPath, read_ms, compile_ms, warmup_ms, config_.warmup_iterations);
+}
 
+ov::CompiledModel YOLO11_BUFF::compile(std::shared_ptr<ov::Model> network)
+{
+  model = network;
+  model->reshape(ov::PartialShape{1, 3, InputSize, InputSize});
+
+  // 输入预处理：u8 NHWC BGR直接送入，类型转换、BGR2RGB和归一化在图内完成
+  ov::preprocess::PrePostProcessor ppp(model);
+  auto & input = ppp.input();
+  input.tensor()
+    .set_element_type(ov::element::u8)
+    .set_shape({1, InputSize, InputSize, 3})
+    .set_layout("NHWC")
+    .set_color_format(ov::preprocess::ColorFormat::BGR);
+  input.model().set_layout("NCHW");
+  input.preprocess()
+    .convert_element_type(ov::element::f32)
+    .convert_color(ov::preprocess::ColorFormat::RGB)
+    .scale(255.0);
+
+  // 输出后处理：在图内按置信度阈值筛选并取top-K个anchor，[1, C, 8400] -> [1, C, K]
+  const int top_k = config_.candidate_top_k;
+  ppp.output().postprocess().custom([top_k](const ov::Output<ov::Node> & node) {
+    return select_candidates(node, ConfidenceThreshold, top_k);
+  });
+  model = ppp.build();
+
+  return core.compile_model(model, "CPU");
+}
 
-  const ov::Tensor output = infer_request.get_output_tensor();  
-  const ov::Shape output_shape = output.get_shape();
-  const float * output_buffer = output.data<const float>();
-  const int out_rows = output_shape[1];  
-  const int out_cols = output_shape[2];  
-  const cv::Mat det_output(
-    out_rows, out_cols, CV_32F, (float *)output_buffer);  
-  std::vector<cv::Rect> boxes;                          
-  std::vector<float> confidences;                       
-  std::vector<std::vector<float>> objects_keypoints;     
-
-  for (int i = 0; i < det_output.cols; ++i) {
-    const float score = det_output.at<float>(4, i);
-    if (score > ConfidenceThreshold) {
-      const float cx = det_output.at<float>(0, i);
-      const float cy = det_output.at<float>(1, i);
-      const float ow = det_output.at<float>(2, i);
-      const float oh = det_output.at<float>(3, i);
-      cv::Rect box;
-      box.x = static_cast<int>((cx - 0.5 * ow) * factor);
-      box.y = static_cast<int>((cy - 0.5 * oh) * factor);
-      box.width = static_cast<int>(ow * factor);
-      box.height = static_cast<int>(oh * factor);
-      boxes.push_back(box);
-
-      confidences.push_back(score);
-
-      std::vector<float> keypoints;
-      cv::Mat kpts = det_output.col(i).rowRange(NUM_POINTS, 15);
-      for (int j = 0; j < NUM_POINTS; ++j) {
-        const float x = kpts.at<float>(j * 2 + 0, 0) * factor;
-        const float y = kpts.at<float>(j * 2 + 1, 0) * factor;
-        keypoints.push_back(x);
-        keypoints.push_back(y);
-      }
-      objects_keypoints.push_back(keypoints);
-    }
+std::vector<YOLO11_BUFF::Object> YOLO11_BUFF::get_multicandidateboxes(const cv::Mat & image)
+{
+  if (image.empty()) {
+    return std::vector<YOLO11_BUFF::Object> ();
   }
 
-  std::vector<int> indexes;
-  cv::dnn::NMSBoxes(boxes, confidences, ConfidenceThreshold, IouThreshold, indexes);
+  auto & slot = sync_slot();
+  slot.img = image;
+  slot.factor = letterbox(image, slot.input, slot.valid_size);
+  slot.request.infer();
+  auto object_result = all_objects(slot);
+  slot.img.release();
+  return object_result;
+}
 
-  std::vector<Object> object_result;  
-  for (size_t i = 0; i < indexes.size(); ++i) {
-    Object obj;
-    const int index = indexes[i];
-    obj.rect = boxes[index];
-    obj.prob = confidences[index];
-
-    const std::vector<float> & keypoint = objects_keypoints[index];
-    for (int i = 0; i < NUM_POINTS; ++i) {
-      const float x_coord = keypoint[i * 2];
-      const float y_coord = keypoint[i * 2 + 1];
-      obj.kpt.push_back(cv::Point2f(x_coord, y_coord));
-    }
-    object_result.push_back(obj);
+std::vector<YOLO11_BUFF::Object> YOLO11_BUFF::get_onecandidatebox(const cv::Mat & image)
+{
+  auto & slot = sync_slot();
+  slot.img = image;
+  slot.factor = letterbox(image, slot.input, slot.valid_size);
+  slot.request.infer();
+  auto object_result = best_object(slot);
+  slot.img.release();
+  return object_result;
+}
 
-    cv::rectangle(image, obj.rect, cv::Scalar(255, 255, 255), 1, 8);           
-    const std::string label = "buff:" + std::to_string(obj.prob).substr(0, 4); 
-    const cv::Size textSize = cv::getTextSize(label, cv::FONT_HERSHEY_SIMPLEX, 0.5, 1, nullptr);
-    const cv::Rect textBox(
-      obj.rect.tl().x, obj.rect.tl().y - 15, textSize.width, textSize.height + 5);
-    cv::rectangle(image, textBox, cv::Scalar(0, 255, 255), cv::FILLED);
-    cv::putText(
-      image, label, cv::Point(obj.rect.tl().x, obj.rect.tl().y - 5), cv::FONT_HERSHEY_SIMPLEX, 0.5,
-      cv::Scalar(0, 0, 0));
-    const int radius = 2;  
-    const cv::Size & shape = image.size();
-    for (int i = 0; i < NUM_POINTS; ++i)
-      cv::circle(image, obj.kpt[i], radius, cv::Scalar(255, 0, 0), -1, cv::LINE_AA);
-  }
+bool YOLO11_BUFF::submit(const cv::Mat & image, std::chrono::steady_clock::time_point timestamp)
+{
+  if (in_flight_.size() == slots_.size()) return false;
 
-  const float t = (cv::getTickCount() - start) / static_cast<float>(cv::getTickFrequency());
-  cv::putText(
-    image, cv::format("FPS: %.2f", 1.0 / t), cv::Point(20, 40), cv::FONT_HERSHEY_PLAIN, 2.0,
-    cv::Scalar(255, 0, 0), 2, 8);
+  auto & slot = slots_[next_slot_];
+  slot.img = image;
+  slot.timestamp = timestamp;
+  slot.factor = letterbox(image, slot.input, slot.valid_size);
+  slot.request.start_async();
 
+  in_flight_.push_back(next_slot_);
+  next_slot_ = (next_slot_ + 1) % slots_.size();
+  return true;
+}
 
-  return object_result;
+std::optional<YOLO11_BUFF::Result> YOLO11_BUFF::poll(bool wait, bool all)
+{
+  if (in_flight_.empty()) return std::nullopt;
+
+  auto & slot = slots_[in_flight_.front()];
+  if (wait)
+    slot.request.wait();
+  else if (!slot.request.wait_for(std::chrono::milliseconds(0)))
+    return std::nullopt;
+  in_flight_.pop_front();
+
+  Result result{slot.img, slot.timestamp, all ? all_objects(slot) : best_object(slot)};
+  slot.img.release();
+  return result;
+}
+
+YOLO11_BUFF::InferSlot & YOLO11_BUFF::sync_slot()
+{
+  if (!in_flight_.empty())
+    throw std::runtime_error("[YOLO11_BUFF] Synchronous call with frames in flight");
+  return slots_[next_slot_];
 }
 
-std::vector<YOLO11_BUFF::Object> YOLO11_BUFF::get_onecandidatebox(cv::Mat & image)
+cv::Mat YOLO11_BUFF::output_mat(InferSlot & slot)
 {
-  const int64 start = cv::getTickCount(); 
-  const float factor = fill_tensor_data_image(input_tensor, image);  
-  infer_request.infer();
-  const ov::Tensor output = infer_request.get_output_tensor(); 
+  const ov::Tensor output = slot.request.get_output_tensor();
   const ov::Shape output_shape = output.get_shape();
-  const float * output_buffer = output.data<const float>();
-  const int out_rows = output_shape[1];  
-  const int out_cols = output_shape[2];  
-  const cv::Mat det_output(
-    out_rows, out_cols, CV_32F, (float *)output_buffer);  
-  int best_index = -1;
-  float max_confidence = 0.0f;
-  for (int i = 0; i < det_output.cols; ++i) {
-    const float confidence = det_output.at<float>(4, i);
-    if (confidence > max_confidence) {
-      max_confidence = confidence;
-      best_index = i;
-    }
-  }
-  std::vector<Object> object_result;  
-  if (max_confidence > ConfidenceThreshold) {
+  return cv::Mat(
+    output_shape[1], output_shape[2], CV_32F, const_cast<float *>(output.data<const float>()));
+}
+
+std::vector<YOLO11_BUFF::Object> YOLO11_BUFF::best_object(InferSlot & slot)
+{
+  std::vector<Object> object_result;
+  if (auto best = decoder_.decode_best(output_mat(slot), slot.factor, ConfidenceThreshold)) {
     Object obj;
-    const float cx = det_output.at<float>(0, best_index);
-    const float cy = det_output.at<float>(1, best_index);
-    const float ow = det_output.at<float>(2, best_index);
-    const float oh = det_output.at<float>(3, best_index);
-    obj.rect.x = static_cast<int>((cx - 0.5 * ow) * factor);
-    obj.rect.y = static_cast<int>((cy - 0.5 * oh) * factor);
-    obj.rect.width = static_cast<int>(ow * factor);
-    obj.rect.height = static_cast<int>(oh * factor);
-    obj.prob = max_confidence;
-    cv::Mat kpts = det_output.col(best_index).rowRange(5, 5 + NUM_POINTS * 2);
-    for (int i = 0; i < NUM_POINTS; ++i) {
-      const float x = kpts.at<float>(i * 2 + 0, 0) * factor;
-      const float y = kpts.at<float>(i * 2 + 1, 0) * factor;
-      obj.kpt.push_back(cv::Point2f(x, y));
-    }
+    obj.rect = best->box;
+    obj.prob = best->confidence;
+    obj.label = best->label;
+    obj.kpt.assign(best->keypoints.begin(), best->keypoints.end());
     object_result.push_back(obj);
-    if (max_confidence < 0.7) save(std::to_string(start), image);
-    cv::rectangle(image, obj.rect, cv::Scalar(255, 255, 255), 1, 8);                 
-    const std::string label = "buff:" + std::to_string(max_confidence).substr(0, 4);  
-    const cv::Size textSize = cv::getTextSize(label, cv::FONT_HERSHEY_SIMPLEX, 0.5, 1, nullptr);
-    const cv::Rect textBox(
-      obj.rect.tl().x, obj.rect.tl().y - 15, textSize.width, textSize.height + 5);
-    cv::rectangle(image, textBox, cv::Scalar(0, 255, 255), cv::FILLED);
-    cv::putText(
-      image, label, cv::Point(obj.rect.tl().x, obj.rect.tl().y - 5), cv::FONT_HERSHEY_SIMPLEX, 0.5,
-      cv::Scalar(0, 0, 0));
-    const int radius = 2;  
-    const cv::Size & shape = image.size();
-    for (int i = 0; i < NUM_POINTS; ++i) {
-      cv::circle(image, obj.kpt[i], radius, cv::Scalar(255, 255, 0), -1, cv::LINE_AA);
-      cv::putText(
-        image, std::to_string(i + 1), obj.kpt[i] + cv::Point2f(5, -5), cv::FONT_HERSHEY_SIMPLEX,
-        0.5, cv::Scalar(255, 255, 0), 1, cv::LINE_AA);
-    }
+    if (obj.prob < UncertainConfidence) save(class_names[obj.label], slot.img);
   }
-  const float t = (cv::getTickCount() - start) / static_cast<float>(cv::getTickFrequency());
-  cv::putText(
-    image, cv::format("FPS: %.2f", 1.0 / t), cv::Point(20, 40), cv::FONT_HERSHEY_PLAIN, 2.0,
-    cv::Scalar(255, 0, 0), 2, 8);
   return object_result;
 }
 
-void YOLO11_BUFF::convert(
-  const cv::Mat & input, cv::Mat & output, const bool normalize, const bool BGR2RGB) const
+std::vector<YOLO11_BUFF::Object> YOLO11_BUFF::all_objects(InferSlot & slot)
 {
-  input.convertTo(output, CV_32F);
-  if (normalize) output = output / 255.0;  
-  if (BGR2RGB) cv::cvtColor(output, output, cv::COLOR_BGR2RGB);
+  auto & candidates = decoder_.decode(output_mat(slot), slot.factor, ConfidenceThreshold);
+
+  // 按类别做NMS，可选把重复框的关键点按置信度加权合并进保留框
+  using Candidate = BuffDecoder::Candidate;
+  tools::nms(
+    candidates, IouThreshold, [](const Candidate & candidate) { return candidate.label; },
+    config_.merge_keypoints);
+
+  std::vector<Object> object_result;
+  bool uncertain = false;
+  for (const auto & candidate : candidates) {
+    Object obj;
+    obj.rect = candidate.box;
+    obj.label = candidate.label;
+    obj.prob = candidate.confidence;
+    obj.kpt.assign(candidate.keypoints.begin(), candidate.keypoints.end());
+    object_result.push_back(obj);
+    uncertain |= obj.prob < UncertainConfidence;
+  }
+  if (uncertain) save(class_names[0], slot.img);
+  return object_result;
 }
 
-float YOLO11_BUFF::fill_tensor_data_image(ov::Tensor & input_tensor, const cv::Mat & input_image) const
+float YOLO11_BUFF::letterbox(const cv::Mat & image, cv::Mat & input, cv::Size & valid_size)
 {
-  const ov::Shape tensor_shape = input_tensor.get_shape();
-  const size_t num_channels = tensor_shape[1];
-  const size_t height = tensor_shape[2];
-  const size_t width = tensor_shape[3];
-  const float scale = std::min(height / float(input_image.rows), width / float(input_image.cols));
-  const cv::Matx23f matrix{
-    scale, 0.0, 0.0, 0.0, scale, 0.0,
-  };
-  cv::Mat blob_image;
-  if (scale < 1.0f) {
-    cv::warpAffine(input_image, blob_image, matrix, cv::Size(width, height));
-    convert(blob_image, blob_image, true, true);
-  } else {
-    convert(input_image, blob_image, true, true);
-    cv::warpAffine(blob_image, blob_image, matrix, cv::Size(width, height));
+  const float scale = std::min(
+    static_cast<float>(InputSize) / image.rows, static_cast<float>(InputSize) / image.cols);
+  const int h = static_cast<int>(image.rows * scale);
+  const int w = static_cast<int>(image.cols * scale);
+
+  // 几何关系变化时才清零右侧和下方的填充带
+  if (valid_size != cv::Size(w, h)) {
+    input(cv::Rect(w, 0, InputSize - w, h)).setTo(cv::Scalar::all(0));
+    input(cv::Rect(0, h, InputSize, InputSize - h)).setTo(cv::Scalar::all(0));
+    valid_size = cv::Size(w, h);
   }
 
-  float * const input_tensor_data = input_tensor.data<float>();
-  for (size_t c = 0; c < num_channels; c++) {
-    for (size_t h = 0; h < height; h++) {
-      for (size_t w = 0; w < width; w++) {
-        input_tensor_data[c * width * height + h * width + w] =
-          blob_image.at<cv::Vec<float, 3>>(h, w)[c];
-      }
-    }
-  }
+  auto dst = input(cv::Rect(0, 0, w, h));
+  cv::resize(image, dst, {w, h});
   return 1 / scale;
 }
 
@@ -259,13 +284,9 @@ void YOLO11_BUFF::printInputAndOutputsInfo(const ov::Model & network)
   }
 }
 
-void YOLO11_BUFF::save(const std::string & programName, const cv::Mat & image)
+void YOLO11_BUFF::save(const std::string & label, const cv::Mat & image)
 {
-  const std::filesystem::path saveDir = "../result/";
-  if (!std::filesystem::exists(saveDir)) {
-    std::filesystem::create_directories(saveDir);
-  }
-  const std::filesystem::path savePath = saveDir / (programName + ".jpg");
-  cv::imwrite(savePath.string(), image);
+  // 只移交原图的引用计数，编码和写盘在后台完成
+  if (dumper_) dumper_->dump(image, label);
 }
 }  // namespace auto_buff
\ No newline at end of file
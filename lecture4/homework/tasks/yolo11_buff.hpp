@@ -1,15 +1,27 @@
 #ifndef AUTO_BUFF__YOLO11_BUFF_HPP
 #define AUTO_BUFF__YOLO11_BUFF_HPP
 
+#include <array>
+#include <chrono>
+#include <deque>
 #include <filesystem>
+#include <memory>
+#include <optional>
 #include <opencv2/opencv.hpp>
 #include <openvino/openvino.hpp>
 
+#include "tasks/yolo11_decoder.hpp"
+#include "tools/sample_dumper.hpp"
+
 
 namespace auto_buff
 {
 const std::vector<std::string> class_names = {"buff", "r"};
 
+// 图内输出后处理：[1, C, N]中置信度不高于threshold的anchor置0，再按置信度取top_k列，得到[1, C, top_k]
+ov::Output<ov::Node> select_candidates(
+  const ov::Output<ov::Node> & output, float threshold, int top_k);
+
 class YOLO11_BUFF
 {
 public:
@@ -21,28 +33,97 @@ public:
     std::vector<cv::Point2f> kpt;
   };
 
+  struct Config
+  {
+    // 图内保留的anchor数，截断发生在NMS之前；每个扇叶有数十个重叠的anchor，
+    // 需远大于 可见扇叶数 × 每个扇叶的anchor数，否则置信度高的扇叶会占满所有名额
+    int candidate_top_k = 300;
+
+    // NMS时把重复框的关键点按置信度加权合并进保留框
+    bool merge_keypoints = false;
+
+    // OpenVINO编译缓存目录，留空不缓存；与模型路径一样位于assets/下
+    std::string cache_dir = "assets/cache/openvino";
+
+    // 构造时的预热推理次数
+    int warmup_iterations = 3;
+
+    // 后台保存低置信度目标所在的原图，用于神经网络的迭代；默认关闭，开启后写入../result/
+    bool sample_dump = false;
+  };
+
   YOLO11_BUFF();
 
-  std::vector<Object> get_multicandidateboxes(cv::Mat & image);
+  explicit YOLO11_BUFF(const Config & config);
+
+  std::vector<Object> get_multicandidateboxes(const cv::Mat & image);
+
+  std::vector<Object> get_onecandidatebox(const cv::Mat & image);
+
+  // 异步接口，结果与get_onecandidatebox相同；同步接口只能在没有在途帧时调用
+  struct Result
+  {
+    cv::Mat img;
+    std::chrono::steady_clock::time_point timestamp;
+    std::vector<Object> objects;
+  };
 
-  std::vector<Object> get_onecandidatebox(cv::Mat & image);
+  // 预处理并提交一帧，两个infer request都在推理时返回false
+  bool submit(const cv::Mat & image, std::chrono::steady_clock::time_point timestamp);
+
+  // 按提交顺序取回最早的一帧；wait为false且该帧未完成时返回空
+  // all为true时返回NMS后的所有目标(同get_multicandidateboxes)，否则只返回置信度最高的一个
+  std::optional<Result> poll(bool wait = true, bool all = false);
+
+  std::size_t in_flight() const { return in_flight_.size(); }
 
 private:
+  static constexpr int NUM_POINTS = BuffLayout::keypoint_num;
+
+  BuffDecoder decoder_;
+
+  Config config_;
+
   ov::Core core;  
   std::shared_ptr<ov::Model> model;
   ov::CompiledModel compiled_model;
-  ov::InferRequest infer_request;
-  ov::Tensor input_tensor;
-  const int NUM_POINTS = 6;
 
-  void convert(
-    const cv::Mat & input, cv::Mat & output, const bool normalize, const bool exchangeRB) const;
+  // 双缓冲：一帧推理时，另一帧在主线程上做预处理、PnP和预测
+  struct InferSlot
+  {
+    ov::InferRequest request;
+    cv::Mat input;        // 与输入张量共享内存的u8 BGR输入
+    cv::Size valid_size;  // 上一次缩放后的有效区域，变化时才清零填充带
+    cv::Mat img;          // 提交时的原图
+    std::chrono::steady_clock::time_point timestamp;
+    float factor;
+  };
+  std::array<InferSlot, 2> slots_;
+  std::size_t next_slot_ = 0;
+  std::deque<std::size_t> in_flight_;  // 在途slot，按提交顺序排列
 
-  float fill_tensor_data_image(ov::Tensor & input_tensor, const cv::Mat & input_image) const;
+  // 同步接口使用的slot，有在途帧时抛出异常
+  InferSlot & sync_slot();
+
+  static cv::Mat output_mat(InferSlot & slot);
+
+  // 置信度最高的一个目标，低置信度时保存原图
+  std::vector<Object> best_object(InferSlot & slot);
+
+  // NMS后的所有目标，有低置信度目标时保存原图
+  std::vector<Object> all_objects(InferSlot & slot);
+
+  // 加入输入预处理和输出后处理后编译
+  ov::CompiledModel compile(std::shared_ptr<ov::Model> network);
+
+  // 等比缩放到input左上角，返回网络坐标到原图的缩放；归一化和通道转换在图内完成
+  static float letterbox(const cv::Mat & image, cv::Mat & input, cv::Size & valid_size);
 
   void printInputAndOutputsInfo(const ov::Model & network);
 
-  void save(const std::string & programName, const cv::Mat & image);
+  std::unique_ptr<tools::SampleDumper> dumper_;  // 未开启sample_dump时为空
+
+  void save(const std::string & label, const cv::Mat & image);
 };
 }  // namespace auto_buff
 #endif
\ No newline at end of file
@@ -0,0 +1,173 @@
+#ifndef AUTO_BUFF__YOLO11_DECODER_HPP
+#define AUTO_BUFF__YOLO11_DECODER_HPP
+
+#include <algorithm>
+#include <array>
+#include <opencv2/core/hal/intrin.hpp>
+#include <opencv2/opencv.hpp>
+#include <optional>
+#include <vector>
+
+namespace auto_buff
+{
+// YOLO11-pose输出为通道优先的[C, K]，每列一个anchor，各行含义由Layout描述
+struct BuffLayout
+{
+  static constexpr int box_row = 0;  // cx, cy, w, h
+  static constexpr int class_row = 4;
+  static constexpr int class_num = 1;  // 每类置信度，已经过sigmoid
+  static constexpr int keypoint_row = class_row + class_num;
+  static constexpr int keypoint_num = 6;
+  static constexpr int keypoint_dims = 2;  // x, y，没有可见度
+  static constexpr int channels = keypoint_row + keypoint_num * keypoint_dims;
+};
+
+/**
+ * 通道优先输出的解码分三步：
+ * 1. 在连续的置信度行上做SIMD阈值比较/求最大值，得到幸存anchor的下标；
+ * 2. 逐通道把幸存anchor的列收集到紧凑的[n, C]缓冲区，每行读取都是递增下标；
+ * 3. 在紧凑缓冲区上逐anchor解码，不再跨8400的步长读取。
+ */
+template <typename Layout>
+class YOLO11Decoder
+{
+public:
+  static_assert(Layout::keypoint_dims >= 2, "keypoints need at least x and y");
+
+  struct Candidate
+  {
+    cv::Rect box;
+    float confidence;
+    int label;
+    std::array<cv::Point2f, Layout::keypoint_num> keypoints;
+  };
+
+  // 解码所有置信度高于threshold的anchor，factor为网络输入到原图的缩放，结果在帧间复用
+  std::vector<Candidate> & decode(const cv::Mat & output, float factor, float threshold)
+  {
+    check(output);
+    const auto * data = output.ptr<float>();
+    const int stride = output.cols;
+
+    max_scores(data, stride);
+    survivors_.clear();
+    int i = 0;
+#if CV_SIMD
+    const auto t = cv::vx_setall_f32(threshold);
+    for (; i + cv::v_float32::nlanes <= stride; i += cv::v_float32::nlanes) {
+      int mask = cv::v_signmask(cv::vx_load(scores_ + i) > t);
+      for (; mask; mask &= mask - 1) survivors_.push_back(i + __builtin_ctz(mask));
+    }
+#endif
+    for (; i < stride; i++)
+      if (scores_[i] > threshold) survivors_.push_back(i);
+
+    gather(data, stride);
+    candidates_.clear();
+    for (std::size_t s = 0; s < survivors_.size(); s++)
+      candidates_.push_back(decode_anchor(gathered_.data() + s * Layout::channels, factor));
+    return candidates_;
+  }
+
+  // 只解码置信度最高的anchor，低于threshold时返回空
+  std::optional<Candidate> decode_best(const cv::Mat & output, float factor, float threshold)
+  {
+    check(output);
+    const auto * data = output.ptr<float>();
+    const int stride = output.cols;
+
+    max_scores(data, stride);
+    float best = threshold;
+    int i = 0;
+#if CV_SIMD
+    auto v_best = cv::vx_setall_f32(threshold);
+    for (; i + cv::v_float32::nlanes <= stride; i += cv::v_float32::nlanes)
+      v_best = cv::v_max(v_best, cv::vx_load(scores_ + i));
+    best = cv::v_reduce_max(v_best);
+#endif
+    for (; i < stride; i++) best = std::max(best, scores_[i]);
+    if (!(best > threshold)) return std::nullopt;
+
+    // 最大值已知，第二遍在连续内存上找第一个等于它的下标
+    const int index = std::find(scores_, scores_ + stride, best) - scores_;
+    std::array<float, Layout::channels> column;
+    for (int c = 0; c < Layout::channels; c++) column[c] = data[c * stride + index];
+    return decode_anchor(column.data(), factor);
+  }
+
+private:
+  const float * scores_ = nullptr;  // 每个anchor在所有类别上的最大置信度
+  std::vector<float> max_scores_;
+  std::vector<int> survivors_;
+  std::vector<float> gathered_;  // [n, channels]
+  std::vector<Candidate> candidates_;
+
+  static void check(const cv::Mat & output)
+  {
+    CV_Assert(output.type() == CV_32F && output.isContinuous());
+    CV_Assert(output.rows >= Layout::channels);
+  }
+
+  // 单类别时直接使用置信度行，多类别时逐行取SIMD最大值
+  void max_scores(const float * data, int stride)
+  {
+    scores_ = data + Layout::class_row * stride;
+    if constexpr (Layout::class_num > 1) {
+      max_scores_.assign(scores_, scores_ + stride);
+      for (int c = 1; c < Layout::class_num; c++) {
+        const float * row = data + (Layout::class_row + c) * stride;
+        int i = 0;
+#if CV_SIMD
+        for (; i + cv::v_float32::nlanes <= stride; i += cv::v_float32::nlanes)
+          cv::v_store(
+            max_scores_.data() + i,
+            cv::v_max(cv::vx_load(max_scores_.data() + i), cv::vx_load(row + i)));
+#endif
+        for (; i < stride; i++) max_scores_[i] = std::max(max_scores_[i], row[i]);
+      }
+      scores_ = max_scores_.data();
+    }
+  }
+
+  void gather(const float * data, int stride)
+  {
+    const auto n = survivors_.size();
+    gathered_.resize(n * Layout::channels);
+    for (int c = 0; c < Layout::channels; c++) {
+      const float * row = data + c * stride;
+      for (std::size_t s = 0; s < n; s++)
+        gathered_[s * Layout::channels + c] = row[survivors_[s]];
+    }
+  }
+
+  // column: 单个anchor的连续通道值
+  static Candidate decode_anchor(const float * column, float factor)
+  {
+    const float * classes = column + Layout::class_row;
+    const int label = std::max_element(classes, classes + Layout::class_num) - classes;
+
+    const float cx = column[Layout::box_row + 0];
+    const float cy = column[Layout::box_row + 1];
+    const float ow = column[Layout::box_row + 2];
+    const float oh = column[Layout::box_row + 3];
+
+    Candidate candidate;
+    candidate.box.x = static_cast<int>((cx - 0.5 * ow) * factor);
+    candidate.box.y = static_cast<int>((cy - 0.5 * oh) * factor);
+    candidate.box.width = static_cast<int>(ow * factor);
+    candidate.box.height = static_cast<int>(oh * factor);
+    candidate.confidence = classes[label];
+    candidate.label = label;
+    for (int j = 0; j < Layout::keypoint_num; j++) {
+      const float * point = column + Layout::keypoint_row + j * Layout::keypoint_dims;
+      candidate.keypoints[j] = cv::Point2f(point[0] * factor, point[1] * factor);
+    }
+    return candidate;
+  }
+};
+
+using BuffDecoder = YOLO11Decoder<BuffLayout>;
+
+}  // namespace auto_buff
+
+#endif  // AUTO_BUFF__YOLO11_DECODER_HPP
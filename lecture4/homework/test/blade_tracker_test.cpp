@@ -0,0 +1,74 @@
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "tasks/blade_tracker.hpp"
+
+constexpr int MaxLostFrames = 30;
+constexpr int ConfirmFrames = 3;
+constexpr double Speed = M_PI / 3 / 100;  // 小符每帧转过的角度(rad)，100fps
+
+static const cv::Point2f RCenter(640, 480);
+
+// 第frame帧时各亮起扇位上的扇叶
+static std::vector<auto_buff::FanBlade> make_blades(const std::vector<int> & slots, int frame)
+{
+  std::vector<auto_buff::FanBlade> fanblades;
+  for (auto slot : slots) {
+    auto angle = 0.5 + Speed * frame + 2 * M_PI * slot / auto_buff::BladeTracker::SLOT_NUM;
+    cv::Point2f center(RCenter.x + 300 * std::cos(angle), RCenter.y + 300 * std::sin(angle));
+    fanblades.emplace_back(std::vector<cv::Point2f>{center}, center, auto_buff::_light);
+  }
+  return fanblades;
+}
+
+// 返回待击打扇叶的个数
+static int run(
+  auto_buff::BladeTracker & tracker, const std::vector<int> & slots, int & frame, int frames)
+{
+  int targets = 0;
+  for (int i = 0; i < frames; i++, frame++) {
+    auto fanblades = make_blades(slots, frame);
+    tracker.update(fanblades, RCenter);
+    targets = 0;
+    for (const auto & fanblade : fanblades) targets += fanblade.type == auto_buff::_target;
+  }
+  return targets;
+}
+
+static bool expect(bool condition, const char * message)
+{
+  if (!condition) std::cerr << message << std::endl;
+  return condition;
+}
+
+int main()
+{
+  auto_buff::BladeTracker tracker(MaxLostFrames, ConfirmFrames);
+  int frame = 0;
+
+  // 中途启动时已亮着的扇位无法区分，不给出待击打扇叶
+  if (!expect(run(tracker, {0, 1}, frame, 50) == 0, "lit blades at startup became a target"))
+    return 1;
+
+  // 2号扇位由熄灭变亮，连续确认后成为待击打扇叶
+  if (!expect(run(tracker, {0, 1, 2}, frame, 1) == 0, "target confirmed on a single frame"))
+    return 1;
+  if (!expect(run(tracker, {0, 1, 2}, frame, ConfirmFrames) == 1, "newly lit blade is no target"))
+    return 1;
+  if (!expect(tracker.slots()[2].type == auto_buff::_target, "wrong slot chosen as target"))
+    return 1;
+
+  // 0号扇位被遮挡远超MaxLostFrames帧后重新出现，不能抢占待击打扇叶
+  run(tracker, {1, 2}, frame, MaxLostFrames * 2);
+  run(tracker, {0, 1, 2}, frame, ConfirmFrames * 2);
+  if (!expect(tracker.slots()[2].type == auto_buff::_target, "reappearing blade stole the target"))
+    return 1;
+
+  // 整个符消失超过MaxLostFrames帧视为重置，之后的扇叶重新判断
+  run(tracker, {}, frame, MaxLostFrames);
+  if (!expect(run(tracker, {3}, frame, 50) == 0, "stale target survived a rune reset")) return 1;
+
+  std::cout << "blade tracker keeps the target through occlusion" << std::endl;
+  return 0;
+}
@@ -0,0 +1,125 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <openvino/openvino.hpp>
+#include <openvino/opsets/opset8.hpp>
+#include <random>
+#include <vector>
+
+#include "tasks/yolo11_buff.hpp"
+#include "tasks/yolo11_decoder.hpp"
+#include "tools/nms.hpp"
+
+// 与YOLO11_BUFF中的阈值一致
+constexpr float ConfidenceThreshold = 0.7f;
+constexpr float IouThreshold = 0.4f;
+constexpr int Anchors = 8400;
+constexpr int BladeNum = 5;
+
+using Candidate = auto_buff::BuffDecoder::Candidate;
+
+// 5个点亮的扇叶绕(320, 320)均布，每个扇叶由多个重叠的anchor给出；
+// 0号扇叶的anchor最多且置信度最高，其余扇叶的置信度都低于它
+static cv::Mat make_output(std::vector<cv::Point2f> & centers)
+{
+  using Layout = auto_buff::BuffLayout;
+  cv::Mat output(Layout::channels, Anchors, CV_32F);
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<float> background(0.0f, 0.5f), jitter(-3.0f, 3.0f);
+  for (int i = 0; i < Anchors; i++) {
+    for (int c = 0; c < Layout::channels; c++) output.at<float>(c, i) = 0;
+    output.at<float>(Layout::class_row, i) = background(rng);
+  }
+
+  std::vector<int> indices(Anchors);
+  for (int i = 0; i < Anchors; i++) indices[i] = i;
+  std::shuffle(indices.begin(), indices.end(), rng);
+
+  std::size_t next = 0;
+  for (int b = 0; b < BladeNum; b++) {
+    auto angle = 2 * CV_PI * b / BladeNum;
+    cv::Point2f center(320 + 200 * std::cos(angle), 320 + 200 * std::sin(angle));
+    centers.push_back(center);
+
+    const int count = b == 0 ? 150 : 40;
+    std::uniform_real_distribution<float> score(b == 0 ? 0.90f : 0.72f, b == 0 ? 0.99f : 0.88f);
+    for (int k = 0; k < count; k++) {
+      const int i = indices[next++];
+      output.at<float>(Layout::box_row + 0, i) = center.x + jitter(rng);
+      output.at<float>(Layout::box_row + 1, i) = center.y + jitter(rng);
+      output.at<float>(Layout::box_row + 2, i) = 80 + jitter(rng);
+      output.at<float>(Layout::box_row + 3, i) = 80 + jitter(rng);
+      output.at<float>(Layout::class_row, i) = score(rng);
+      for (int j = 0; j < Layout::keypoint_num; j++) {
+        const int row = Layout::keypoint_row + j * Layout::keypoint_dims;
+        output.at<float>(row, i) = center.x + jitter(rng);
+        output.at<float>(row + 1, i) = center.y + jitter(rng);
+      }
+    }
+  }
+  return output;
+}
+
+// 图内筛选+解码+NMS，返回保留下来的目标
+static std::vector<Candidate> detect(const cv::Mat & output, int top_k)
+{
+  const ov::Shape shape{1, static_cast<size_t>(output.rows), Anchors};
+  auto input = std::make_shared<ov::opset8::Parameter>(ov::element::f32, shape);
+  auto selected = auto_buff::select_candidates(input->output(0), ConfidenceThreshold, top_k);
+  auto model = std::make_shared<ov::Model>(
+    ov::OutputVector{selected}, ov::ParameterVector{input}, "select_candidates");
+
+  ov::Core core;
+  auto request = core.compile_model(model, "CPU").create_infer_request();
+  request.set_input_tensor(
+    ov::Tensor(ov::element::f32, shape, const_cast<float *>(output.ptr<float>())));
+  request.infer();
+
+  const ov::Tensor result = request.get_output_tensor();
+  const ov::Shape result_shape = result.get_shape();
+  const cv::Mat filtered(
+    result_shape[1], result_shape[2], CV_32F, const_cast<float *>(result.data<const float>()));
+
+  auto_buff::BuffDecoder decoder;
+  auto candidates = decoder.decode(filtered, 1.0f, ConfidenceThreshold);
+  tools::nms(
+    candidates, IouThreshold, [](const Candidate & candidate) { return candidate.label; }, true);
+  return candidates;
+}
+
+static int count_found(
+  const std::vector<Candidate> & candidates, const std::vector<cv::Point2f> & centers)
+{
+  int found = 0;
+  for (const auto & center : centers) {
+    found += std::any_of(candidates.begin(), candidates.end(), [&](const Candidate & candidate) {
+      return cv::norm(candidate.keypoints[4] - center) < 10;
+    });
+  }
+  return found;
+}
+
+int main()
+{
+  std::vector<cv::Point2f> centers;
+  const auto output = make_output(centers);
+
+  // 场景本身要能暴露NMS前的截断：K=32时名额全部被0号扇叶占满
+  auto truncated = detect(output, 32);
+  if (count_found(truncated, centers) == BladeNum) {
+    std::cerr << "scenario does not stress the top-K cut" << std::endl;
+    return 1;
+  }
+
+  // 默认配置下5个扇叶都要保留，且NMS后每个扇叶只剩一个目标
+  auto candidates = detect(output, auto_buff::YOLO11_BUFF::Config().candidate_top_k);
+  const auto found = count_found(candidates, centers);
+  if (found != BladeNum || candidates.size() != BladeNum) {
+    std::cerr << "expected " << BladeNum << " blades, found " << found << " of "
+              << candidates.size() << " candidates" << std::endl;
+    return 1;
+  }
+
+  std::cout << "all " << BladeNum << " blades survive top-K and NMS" << std::endl;
+  return 0;
+}
@@ -0,0 +1,40 @@
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+#include "tasks/speed_fitter.hpp"
+
+// 小符转速为常数π/3 rad/s；100fps下连续运行约70分钟，
+// 超过未观测参数的方差按遗忘因子增长到溢出所需的帧数
+constexpr double SmallSpeed = M_PI / 3;
+constexpr double FrameInterval = 0.01;
+constexpr int Frames = 420000;
+
+int main()
+{
+  auto_buff::SpeedFitter fitter(auto_buff::SMALL);
+  const std::chrono::steady_clock::time_point start{};
+
+  for (int i = 0; i < Frames; i++) {
+    const double t = i * FrameInterval;
+    const double angle = std::remainder(0.3 + SmallSpeed * t, 2 * M_PI);  // 模拟atan2的±π跳变
+    const auto timestamp =
+      start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double>(t));
+    fitter.update(angle, timestamp);
+
+    // 每分钟检查一次，定位发散开始的时刻
+    if (i % 6000 != 5999) continue;
+    const auto predicted = fitter.predict(0.5);
+    const auto speed = fitter.speed(0);
+    if (!predicted || !std::isfinite(*predicted) || !std::isfinite(speed) ||
+        std::abs(speed - SmallSpeed) > 1e-3 || std::abs(*predicted - SmallSpeed * 0.5) > 1e-3) {
+      std::cerr << "fit diverged after " << t << " s: speed " << speed << ", predict "
+                << (predicted ? *predicted : NAN) << std::endl;
+      return 1;
+    }
+  }
+
+  std::cout << "small rune fit stays finite over " << Frames * FrameInterval << " s" << std::endl;
+  return 0;
+}
@@ -0,0 +1,83 @@
+#include "overlay.hpp"
+
+namespace tools
+{
+Overlay::Overlay(double scale) : scale_(scale), thread_(&Overlay::render_loop, this) {}
+
+Overlay::~Overlay()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    quit_ = true;
+  }
+  cv_.notify_all();
+  thread_.join();
+}
+
+void Overlay::subscribe() { subscribers_++; }
+
+void Overlay::unsubscribe()
+{
+  if (--subscribers_ > 0) return;
+
+  // 最后一个订阅者退出时丢弃未取走的画面
+  std::lock_guard<std::mutex> lock(mutex_);
+  pending_img_.release();
+  pending_draw_ = nullptr;
+  rendered_.release();
+  has_rendered_ = false;
+}
+
+void Overlay::submit(const cv::Mat & img, Draw draw)
+{
+  if (!subscribed() || img.empty()) return;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_img_ = img;
+    pending_draw_ = std::move(draw);
+  }
+  cv_.notify_one();
+}
+
+bool Overlay::take(cv::Mat & canvas)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!has_rendered_) return false;
+
+  canvas = rendered_;
+  rendered_.release();
+  has_rendered_ = false;
+  return true;
+}
+
+void Overlay::render_loop()
+{
+  while (true) {
+    cv::Mat img;
+    Draw draw;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this] { return quit_ || !pending_img_.empty(); });
+      if (quit_) return;
+
+      img = pending_img_;
+      draw = std::move(pending_draw_);
+      pending_img_.release();
+      pending_draw_ = nullptr;
+    }
+
+    // 缩小得到的画布是新分配的，绘制不会影响检测线程持有的原图
+    cv::Mat canvas;
+    cv::resize(img, canvas, {}, scale_, scale_);
+    if (draw) draw(canvas, scale_);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (subscribed()) {
+      rendered_ = canvas;
+      has_rendered_ = true;
+    }
+  }
+}
+
+}  // namespace tools
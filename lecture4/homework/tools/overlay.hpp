@@ -0,0 +1,57 @@
+#ifndef TOOLS__OVERLAY_HPP
+#define TOOLS__OVERLAY_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <opencv2/opencv.hpp>
+#include <thread>
+
+namespace tools
+{
+/**
+ * 调试画面的异步渲染：检测线程只提交原图(引用计数，不拷贝)和绘制函数，
+ * 缩小和绘制都在渲染线程中完成。没有订阅者时submit直接返回；
+ * 渲染线程忙时新提交的帧覆盖尚未渲染的旧帧。
+ */
+class Overlay
+{
+public:
+  // 在缩小后的画布上绘制，scale为画布相对原图的缩放比例
+  using Draw = std::function<void(cv::Mat & canvas, double scale)>;
+
+  explicit Overlay(double scale = 0.5);
+  ~Overlay();
+
+  // 显示窗口等观察者在使用前后调用，可多次订阅
+  void subscribe();
+  void unsubscribe();
+  bool subscribed() const { return subscribers_ > 0; }
+
+  // 调用方提交后不能再原地修改img
+  void submit(const cv::Mat & img, Draw draw);
+
+  // 取出最新一帧渲染结果，没有新结果时返回false
+  bool take(cv::Mat & canvas);
+
+private:
+  const double scale_;
+  std::atomic<int> subscribers_{0};
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool quit_ = false;
+  cv::Mat pending_img_;
+  Draw pending_draw_;
+  cv::Mat rendered_;
+  bool has_rendered_ = false;
+
+  std::thread thread_;
+
+  void render_loop();
+};
+
+}  // namespace tools
+
+#endif  // TOOLS__OVERLAY_HPP
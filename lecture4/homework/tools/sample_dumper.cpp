@@ -0,0 +1,108 @@
+#include "sample_dumper.hpp"
+
+#include <fmt/chrono.h>
+#include <fmt/format.h>
+
+#include <filesystem>
+#include <fstream>
+
+#include "logger.hpp"
+
+namespace tools
+{
+SampleDumper::SampleDumper(
+  const std::string & save_dir, std::size_t queue_size, int workers, double min_interval,
+  std::size_t quota_mb)
+: save_dir_(save_dir),
+  queue_size_(queue_size),
+  min_interval_(min_interval),
+  quota_bytes_(static_cast<std::uintmax_t>(quota_mb) << 20)
+{
+  if (queue_size_ == 0 || workers < 1)
+    throw std::runtime_error("SampleDumper needs a positive queue size and worker count!");
+
+  // 配额包含目录中已有的文件，重启后不会重新计算
+  std::filesystem::create_directories(save_dir_);
+  for (const auto & entry : std::filesystem::directory_iterator(save_dir_)) {
+    if (entry.is_regular_file()) used_bytes_ += entry.file_size();
+  }
+
+  for (int i = 0; i < workers; i++) workers_.emplace_back(&SampleDumper::work, this);
+}
+
+SampleDumper::~SampleDumper()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    quit_ = true;
+  }
+  cv_.notify_all();
+  for (auto & worker : workers_) worker.join();
+
+  tools::logger()->info(
+    "[SampleDumper] saved {}, dropped {}, {:.1f} MB used in {}", saved_.load(), dropped_.load(),
+    used_bytes_ / 1048576.0, save_dir_);
+}
+
+bool SampleDumper::dump(const cv::Mat & img, const std::string & label)
+{
+  if (img.empty()) return false;
+
+  auto now = std::chrono::steady_clock::now();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto last = last_dump_.find(label);
+    auto throttled = last != last_dump_.end() && now - last->second < min_interval_;
+    if (throttled || queue_.size() >= queue_size_ || used_bytes_ >= quota_bytes_) {
+      dropped_++;
+      return false;
+    }
+
+    last_dump_[label] = now;
+    queue_.push_back({img, label, next_id_++});
+  }
+  cv_.notify_one();
+  return true;
+}
+
+void SampleDumper::work()
+{
+  std::vector<uchar> buffer;
+  while (true) {
+    Sample sample;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this] { return quit_ || !queue_.empty(); });
+      if (queue_.empty()) return;  // 退出前先保存完队列中的样本
+
+      sample = std::move(queue_.front());
+      queue_.pop_front();
+    }
+
+    cv::imencode(".jpg", sample.img, buffer);
+    sample.img.release();
+
+    // 先占用配额再写盘，多个工作线程之间不会超额
+    auto used = used_bytes_.fetch_add(buffer.size());
+    if (used + buffer.size() > quota_bytes_) {
+      used_bytes_ -= buffer.size();
+      dropped_++;
+      continue;
+    }
+
+    auto file_name = fmt::format(
+      "{}/{}_{:%Y-%m-%d_%H-%M-%S}_{}.jpg", save_dir_, sample.label,
+      std::chrono::system_clock::now(), sample.id);
+    std::ofstream file(file_name, std::ios::binary);
+    file.write(reinterpret_cast<const char *>(buffer.data()), buffer.size());
+    if (!file) {
+      used_bytes_ -= buffer.size();
+      dropped_++;
+      tools::logger()->warn("[SampleDumper] Failed to write {}", file_name);
+      continue;
+    }
+    saved_++;
+  }
+}
+
+}  // namespace tools
@@ -0,0 +1,68 @@
+#ifndef TOOLS__SAMPLE_DUMPER_HPP
+#define TOOLS__SAMPLE_DUMPER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace tools
+{
+/**
+ * 后台保存样本图片，用于收集难例迭代神经网络。
+ * dump只在检测线程上做限流判断并把图像(引用计数，不拷贝)放入有界队列，
+ * JPEG编码和写盘在工作线程中完成；队列满、同类样本过于频繁或超出磁盘配额时直接丢弃。
+ * 调用方提交后不能再原地修改img。
+ */
+class SampleDumper
+{
+public:
+  SampleDumper(
+    const std::string & save_dir, std::size_t queue_size, int workers, double min_interval,
+    std::size_t quota_mb);
+  ~SampleDumper();
+
+  // 按label分类限流，min_interval秒内同一label只保存一张；被丢弃时返回false
+  bool dump(const cv::Mat & img, const std::string & label);
+
+  std::size_t saved() const { return saved_; }
+  std::size_t dropped() const { return dropped_; }
+
+private:
+  struct Sample
+  {
+    cv::Mat img;
+    std::string label;
+    std::uint64_t id;
+  };
+
+  const std::string save_dir_;
+  const std::size_t queue_size_;
+  const std::chrono::duration<double> min_interval_;
+  const std::uintmax_t quota_bytes_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool quit_ = false;
+  std::deque<Sample> queue_;
+  std::unordered_map<std::string, std::chrono::steady_clock::time_point> last_dump_;
+  std::uint64_t next_id_ = 0;
+
+  std::atomic<std::uintmax_t> used_bytes_{0};
+  std::atomic<std::size_t> saved_{0}, dropped_{0};
+
+  std::vector<std::thread> workers_;
+
+  void work();
+};
+
+}  // namespace tools
+
+#endif  // TOOLS__SAMPLE_DUMPER_HPP